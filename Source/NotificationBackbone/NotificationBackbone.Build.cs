@@ -28,6 +28,7 @@ public class NotificationBackbone : ModuleRules
 			new string[]
 			{
 				"Core",
+				"Json",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -41,6 +42,7 @@ public class NotificationBackbone : ModuleRules
                 "UnrealEd",
 				"Slate",
 				"SlateCore",
+				"Projects",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -1,18 +1,25 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "NotificationBackbone.h"
+#include "NotificationBackboneManager.h"
 
 #define LOCTEXT_NAMESPACE "FNotificationBackboneModule"
 
 void FNotificationBackboneModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	// Create the manager on the game thread. A worker thread could be the first one to dispatch otherwise.
+	FNotificationBackboneManager::Get();
 }
 
 void FNotificationBackboneModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	// The capture has a thread of its own, it must not be left to the static destructors.
+	FNotificationBackboneManager::Get().StopCapture();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -1,3 +1,70 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "NotificationBackboneBPTypes.h"
+#include "NotificationBackboneJson.h"
+#include "NotificationBackboneDeferredText.h"
+#include "Engine/Texture2D.h"
+
+UTexture2D* FNotificationBackboneMessageData::GetIcon() const
+{
+	return icon ? icon : softIcon.Get();
+}
+
+void FNotificationBackboneNotification::SetJson(const FString& jsonString)
+{
+	json = MakeShared<FNotificationBackboneJsonPayload, ESPMode::ThreadSafe>(jsonString);
+}
+
+void FNotificationBackboneNotification::SetJson(const TSharedRef<FJsonObject>& jsonObject)
+{
+	json = MakeShared<FNotificationBackboneJsonPayload, ESPMode::ThreadSafe>(jsonObject);
+}
+
+TSharedPtr<FJsonObject> FNotificationBackboneNotification::GetJson() const
+{
+	return json.IsValid() ? json->GetObject() : nullptr;
+}
+
+void FNotificationBackboneNotification::SetDeferredTitle(const FTextFormat& format, FFormatNamedArguments arguments)
+{
+	deferredTitle = MakeShared<FNotificationBackboneDeferredText, ESPMode::ThreadSafe>(format, MoveTemp(arguments));
+}
+
+void FNotificationBackboneNotification::SetDeferredTitle(const FTextFormat& format, FFormatOrderedArguments arguments)
+{
+	deferredTitle = MakeShared<FNotificationBackboneDeferredText, ESPMode::ThreadSafe>(format, MoveTemp(arguments));
+}
+
+void FNotificationBackboneNotification::SetDeferredMessage(const FTextFormat& format, FFormatNamedArguments arguments)
+{
+	deferredMessage = MakeShared<FNotificationBackboneDeferredText, ESPMode::ThreadSafe>(format, MoveTemp(arguments));
+}
+
+void FNotificationBackboneNotification::SetDeferredMessage(const FTextFormat& format, FFormatOrderedArguments arguments)
+{
+	deferredMessage = MakeShared<FNotificationBackboneDeferredText, ESPMode::ThreadSafe>(format, MoveTemp(arguments));
+}
+
+const FText& FNotificationBackboneNotification::GetTitle() const
+{
+	return deferredTitle.IsValid() ? deferredTitle->Get() : title;
+}
+
+const FText& FNotificationBackboneNotification::GetMessage() const
+{
+	return deferredMessage.IsValid() ? deferredMessage->Get() : message;
+}
+
+void FNotificationBackboneNotification::ResolveDeferredText()
+{
+	if (deferredTitle.IsValid())
+	{
+		title = deferredTitle->Get();
+		deferredTitle.Reset();
+	}
+	if (deferredMessage.IsValid())
+	{
+		message = deferredMessage->Get();
+		deferredMessage.Reset();
+	}
+}
@@ -0,0 +1,494 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneBenchmark.h"
+#include "NotificationBackboneManager.h"
+#include "NotificationBackboneSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "Containers/Ticker.h"
+#include "UObject/Package.h"
+
+namespace NotificationBackboneBenchmark
+{
+	// Counts what it gets. Optionally notes down the time between two notifications, e.g. while a feed drains in one go,
+	// or the time since the notification got dispatched, looked up by its title.
+	class FRawListener : public INotificationBackboneListenerRaw
+	{
+	public:
+		virtual void OnNotification(const FNotificationBackboneNotification& notification) override
+		{
+			++numNotifications;
+			if (intervalCycles)
+			{
+				const uint64 nowCycles = FPlatformTime::Cycles64();
+				intervalCycles->Add(nowCycles - lastCycles);
+				lastCycles = nowCycles;
+			}
+			if (latencyCycles && dispatchCycles)
+			{
+				const int32 index = FCString::Atoi(*notification.title.ToString());
+				if (dispatchCycles->IsValidIndex(index))
+				{
+					latencyCycles->Add(FPlatformTime::Cycles64() - (*dispatchCycles)[index]);
+				}
+			}
+		}
+
+		virtual FName GetNotificationBackboneListenerName() override
+		{
+			return FName("NotificationBackboneBenchmark");
+		}
+
+		int32 numNotifications = 0;
+		TArray<uint64>* intervalCycles = nullptr;
+		uint64 lastCycles = 0;
+		const TArray<uint64>* dispatchCycles = nullptr;
+		TArray<uint64>* latencyCycles = nullptr;
+	};
+
+	static FNotificationBackboneNotification MakeNotification(const FName& feed)
+	{
+		FNotificationBackboneNotification notification = FNotificationBackboneNotification();
+		notification.feed = feed;
+		notification.title = FText::FromString(TEXT("Benchmark"));
+		notification.message = FText::FromString(TEXT("NotificationBackbone benchmark notification"));
+		return notification;
+	}
+
+	static double CyclesToMicroseconds(uint64 cycles)
+	{
+		return cycles * FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+	}
+
+	// Samples must be sorted.
+	static double GetPercentileMicroseconds(const TArray<uint64>& sortedCycles, double fraction)
+	{
+		if (sortedCycles.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 index = FMath::Clamp(FMath::CeilToInt(sortedCycles.Num() * fraction) - 1, 0, sortedCycles.Num() - 1);
+		return CyclesToMicroseconds(sortedCycles[index]);
+	}
+
+	static const FName ChurnFeed(TEXT("NotificationBackboneBenchmark.Churn"));
+	static const FName DelayedFeed(TEXT("NotificationBackboneBenchmark.Delayed"));
+}
+
+using namespace NotificationBackboneBenchmark;
+
+FNotificationBackboneBenchmark::~FNotificationBackboneBenchmark()
+{
+	if (step != EStep::Start && step != EStep::Done)
+	{
+		// Stopped halfway, e.g. the test got aborted.
+		if (listener.IsValid())
+		{
+			FNotificationBackboneManager::Get().UnregisterFromNotifications(listener.ToSharedRef(), DelayedFeed);
+			CleanUpFeed(DelayedFeed);
+		}
+		Finish();
+	}
+}
+
+bool FNotificationBackboneBenchmark::Tick()
+{
+	check(IsInGameThread());
+
+	switch (step)
+	{
+	case EStep::Start:
+		Start();
+		step = EStep::Dispatch;
+		return false;
+	case EStep::Dispatch:
+		RunDispatch(TEXT("Dispatch.Raw"), 1, 0);
+		RunDispatch(TEXT("Dispatch.Raw"), 10, 0);
+		RunDispatch(TEXT("Dispatch.Raw"), 1000, 0);
+		RunDispatch(TEXT("Dispatch.UObject"), 0, 10);
+		RunDispatch(TEXT("Dispatch.Mixed"), 5, 5);
+		RunDispatch(TEXT("Dispatch.Mixed"), 500, 500);
+		step = EStep::FeedChurn;
+		return false;
+	case EStep::FeedChurn:
+		if (TickFeedChurn())
+		{
+			StartDelayedFeed();
+			step = EStep::DelayedFeed;
+		}
+		return false;
+	case EStep::DelayedFeed:
+		if (TickDelayedFeed())
+		{
+			step = EStep::CachedFeed;
+		}
+		return false;
+	case EStep::CachedFeed:
+		RunCachedFeed();
+		Finish();
+		step = EStep::Done;
+		return true;
+	case EStep::Done:
+	default:
+		return true;
+	}
+}
+
+void FNotificationBackboneBenchmark::Start()
+{
+	results.Reset();
+
+	// The global budget would spread the dispatches over frames and measure the frame time instead.
+	UNotificationBackboneSettings* backboneSettings = GetMutableDefault<UNotificationBackboneSettings>();
+	maxDispatchesPerFrame = backboneSettings->maxDispatchesPerFrame;
+	maxDispatchMicrosecondsPerFrame = backboneSettings->maxDispatchMicrosecondsPerFrame;
+	idleFeedGracePeriod = backboneSettings->idleFeedGracePeriod;
+	backboneSettings->maxDispatchesPerFrame = 0;
+	backboneSettings->maxDispatchMicrosecondsPerFrame = 0.f;
+	// Empty feeds go away the next time the manager ticks, the churn scenario measures that cycle.
+	backboneSettings->idleFeedGracePeriod = 0.f;
+
+	MF_LOG(Log, false, "Running the benchmark. Iterations: %d, CachedNotifications: %d", options.iterations, options.numCachedNotifications);
+}
+
+void FNotificationBackboneBenchmark::Finish()
+{
+	UNotificationBackboneSettings* backboneSettings = GetMutableDefault<UNotificationBackboneSettings>();
+	backboneSettings->maxDispatchesPerFrame = maxDispatchesPerFrame;
+	backboneSettings->maxDispatchMicrosecondsPerFrame = maxDispatchMicrosecondsPerFrame;
+	backboneSettings->idleFeedGracePeriod = idleFeedGracePeriod;
+
+	for (const FNotificationBackboneBenchmarkResult& result : results)
+	{
+		MF_LOG(Display, false, "%s (%d listeners): %d samples, %.1f/s, p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us",
+			*result.scenario, result.numListeners, result.numSamples, result.samplesPerSecond,
+			result.p50Microseconds, result.p90Microseconds, result.p99Microseconds, result.maxMicroseconds);
+	}
+}
+
+void FNotificationBackboneBenchmark::RunDispatch(const TCHAR* scenario, int32 numRawListeners, int32 numObjectListeners)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	const FName feed(TEXT("NotificationBackboneBenchmark.Dispatch"));
+	manager.OverrideFeedSettings(feed, [&feed](FNotificationBackboneFeedSettings& settings)
+	{
+		settings = FNotificationBackboneFeedSettings();
+		settings.feed = feed;
+	});
+
+	TArray<TSharedRef<FRawListener>> rawListeners;
+	for (int32 index = 0; index < numRawListeners; ++index)
+	{
+		rawListeners.Add(MakeShareable(new FRawListener()));
+		manager.RegisterForNotifications(rawListeners.Last(), feed);
+	}
+	TArray<UNotificationBackboneBenchmarkListener*> objectListeners;
+	for (int32 index = 0; index < numObjectListeners; ++index)
+	{
+		UNotificationBackboneBenchmarkListener* objectListener = NewObject<UNotificationBackboneBenchmarkListener>(GetTransientPackage());
+		objectListener->AddToRoot();
+		objectListeners.Add(objectListener);
+		manager.RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener>(objectListener), feed);
+	}
+
+	const FNotificationBackboneNotification notification = MakeNotification(feed);
+	TArray<uint64> dispatchSampleCycles;
+	dispatchSampleCycles.Reserve(options.iterations);
+	for (int32 iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		const uint64 startCycles = FPlatformTime::Cycles64();
+		manager.DispatchNotification(notification);
+		dispatchSampleCycles.Add(FPlatformTime::Cycles64() - startCycles);
+	}
+
+	for (const TSharedRef<FRawListener>& rawListener : rawListeners)
+	{
+		manager.UnregisterFromNotifications(rawListener, feed);
+	}
+	for (UNotificationBackboneBenchmarkListener* objectListener : objectListeners)
+	{
+		manager.UnregisterFromNotificationsUObject(TScriptInterface<INotificationBackboneListener>(objectListener), feed);
+		objectListener->RemoveFromRoot();
+	}
+	CleanUpFeed(feed);
+
+	AddResult(scenario, numRawListeners + numObjectListeners, dispatchSampleCycles);
+}
+
+bool FNotificationBackboneBenchmark::TickFeedChurn()
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	if (!listener.IsValid())
+	{
+		listener = MakeShareable(new FRawListener());
+		numChurnedFeeds = 0;
+		scenarioSampleCycles.Reset(options.iterations);
+	}
+
+	// Names up front, building them is not what we measure. The numbers start over every frame, the feeds of the last frame got
+	// destroyed meanwhile, so the names get reused like the feed objects.
+	const int32 numFeeds = FMath::Min(FMath::Max(options.numChurnFeedsPerFrame, 1), options.iterations - numChurnedFeeds);
+	TArray<FName> feeds;
+	feeds.Reserve(numFeeds);
+	for (int32 index = 0; index < numFeeds; ++index)
+	{
+		feeds.Add(FName(ChurnFeed, index + 1));
+	}
+
+	// Register creates the feed, taking a recycled one if there is one. Unregister retires the empty feed, the tick destroys it.
+	TSharedRef<INotificationBackboneListenerRaw> churnListener = listener.ToSharedRef();
+	for (const FName& feed : feeds)
+	{
+		const uint64 startCycles = FPlatformTime::Cycles64();
+		manager.RegisterForNotifications(churnListener, feed);
+		manager.UnregisterFromNotifications(churnListener, feed);
+		scenarioSampleCycles.Add(FPlatformTime::Cycles64() - startCycles);
+	}
+	numChurnedFeeds += numFeeds;
+
+	if (numChurnedFeeds < options.iterations)
+	{
+		return false;
+	}
+
+	AddResult(TEXT("FeedChurn"), 1, scenarioSampleCycles);
+	listener.Reset();
+	return true;
+}
+
+void FNotificationBackboneBenchmark::StartDelayedFeed()
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	manager.OverrideFeedSettings(DelayedFeed, [](FNotificationBackboneFeedSettings& settings)
+	{
+		settings = FNotificationBackboneFeedSettings();
+		settings.feed = DelayedFeed;
+		settings.dispatchDelay = 0.01f;
+		settings.dispatchBatchSize = 4;
+	});
+
+	TSharedRef<FRawListener> delayedListener = MakeShareable(new FRawListener());
+	scenarioSampleCycles.Reset(options.iterations);
+	dispatchCycles.Reset(options.iterations);
+	delayedListener->dispatchCycles = &dispatchCycles;
+	delayedListener->latencyCycles = &scenarioSampleCycles;
+	listener = delayedListener;
+	manager.RegisterForNotifications(delayedListener, DelayedFeed);
+
+	// The title carries the index, the listener looks the dispatch time up by it.
+	FNotificationBackboneNotification notification = MakeNotification(DelayedFeed);
+	for (int32 iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		notification.title = FText::AsCultureInvariant(FString::FromInt(iteration));
+		dispatchCycles.Add(FPlatformTime::Cycles64());
+		manager.DispatchNotification(notification);
+	}
+	numFrames = 0;
+	startSeconds = FPlatformTime::Seconds();
+}
+
+bool FNotificationBackboneBenchmark::TickDelayedFeed()
+{
+	// The manager ticks on its own between our ticks. About two batches per frame at 60 frames per second.
+	const FRawListener& delayedListener = static_cast<const FRawListener&>(*listener);
+	const int32 maxFrames = options.iterations + 10;
+	if (delayedListener.numNotifications < options.iterations && ++numFrames < maxFrames)
+	{
+		return false;
+	}
+
+	const double drainSeconds = FPlatformTime::Seconds() - startSeconds;
+	const int32 numNotifications = delayedListener.numNotifications;
+	FNotificationBackboneManager::Get().UnregisterFromNotifications(listener.ToSharedRef(), DelayedFeed);
+	listener.Reset();
+	CleanUpFeed(DelayedFeed);
+
+	// Latency includes the delay of the feed and the frames in between. Throughput in notifications per second while it drained.
+	FNotificationBackboneBenchmarkResult& result = AddResult(TEXT("DelayedFeed.Latency"), 1, scenarioSampleCycles);
+	result.samplesPerSecond = drainSeconds > 0.0 ? numNotifications / drainSeconds : 0.0;
+	return true;
+}
+
+void FNotificationBackboneBenchmark::RunCachedFeed()
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	const FName feed(TEXT("NotificationBackboneBenchmark.Cached"));
+	manager.OverrideFeedSettings(feed, [&feed](FNotificationBackboneFeedSettings& settings)
+	{
+		settings = FNotificationBackboneFeedSettings();
+		settings.feed = feed;
+		settings.bCacheNotificationsNoListeners = true;
+	});
+
+	const FNotificationBackboneNotification notification = MakeNotification(feed);
+	TArray<uint64> enqueueSampleCycles;
+	enqueueSampleCycles.Reserve(options.numCachedNotifications);
+
+	const uint64 usedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	for (int32 iteration = 0; iteration < options.numCachedNotifications; ++iteration)
+	{
+		const uint64 startCycles = FPlatformTime::Cycles64();
+		manager.DispatchNotification(notification);
+		enqueueSampleCycles.Add(FPlatformTime::Cycles64() - startCycles);
+	}
+	const uint64 usedMemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	FNotificationBackboneBenchmarkResult& enqueueResult = AddResult(TEXT("CachedFeed.Enqueue"), 0, enqueueSampleCycles);
+	if (usedMemoryAfter > usedMemoryBefore && options.numCachedNotifications > 0)
+	{
+		enqueueResult.bytesPerItem = (double)(usedMemoryAfter - usedMemoryBefore) / options.numCachedNotifications;
+	}
+
+	// The whole feed drains while the listener subscribes. The listener notes down the time between two notifications.
+	TSharedRef<FRawListener> cachedListener = MakeShareable(new FRawListener());
+	TArray<uint64> drainSampleCycles;
+	drainSampleCycles.Reserve(options.numCachedNotifications);
+	cachedListener->intervalCycles = &drainSampleCycles;
+	cachedListener->lastCycles = FPlatformTime::Cycles64();
+	manager.RegisterForNotifications(cachedListener, feed);
+	cachedListener->intervalCycles = nullptr;
+
+	manager.UnregisterFromNotifications(cachedListener, feed);
+	CleanUpFeed(feed);
+
+	AddResult(TEXT("CachedFeed.Drain"), 1, drainSampleCycles);
+}
+
+FNotificationBackboneBenchmarkResult& FNotificationBackboneBenchmark::AddResult(const TCHAR* scenario, int32 numListeners, TArray<uint64>& sampleCycles)
+{
+	sampleCycles.Sort();
+
+	uint64 totalCycles = 0;
+	for (uint64 cycles : sampleCycles)
+	{
+		totalCycles += cycles;
+	}
+
+	FNotificationBackboneBenchmarkResult& result = results[results.AddDefaulted()];
+	result.scenario = scenario;
+	result.numListeners = numListeners;
+	result.numSamples = sampleCycles.Num();
+	result.totalMilliseconds = CyclesToMicroseconds(totalCycles) / 1000.0;
+	result.samplesPerSecond = result.totalMilliseconds > 0.0 ? sampleCycles.Num() / (result.totalMilliseconds / 1000.0) : 0.0;
+	result.p50Microseconds = GetPercentileMicroseconds(sampleCycles, 0.5);
+	result.p90Microseconds = GetPercentileMicroseconds(sampleCycles, 0.9);
+	result.p99Microseconds = GetPercentileMicroseconds(sampleCycles, 0.99);
+	result.maxMicroseconds = sampleCycles.Num() > 0 ? CyclesToMicroseconds(sampleCycles.Last()) : 0.0;
+	return result;
+}
+
+void FNotificationBackboneBenchmark::CleanUpFeed(const FName& feed)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	manager.ClearNotificationFeedNotifications(feed);
+	manager.ClearFeedSettingsOverrides(feed);
+	manager.ResetFeedStats(feed);
+}
+
+FNotificationBackboneBenchmark::FOptions FNotificationBackboneBenchmark::ParseOptions(const TCHAR* commandLine)
+{
+	FOptions parsedOptions;
+	FParse::Value(commandLine, TEXT("NotificationBackboneBenchmarkIterations="), parsedOptions.iterations);
+	FParse::Value(commandLine, TEXT("NotificationBackboneBenchmarkCached="), parsedOptions.numCachedNotifications);
+	FParse::Value(commandLine, TEXT("NotificationBackboneBenchmarkOutput="), parsedOptions.outputDirectory);
+	parsedOptions.iterations = FMath::Max(parsedOptions.iterations, 1);
+	parsedOptions.numCachedNotifications = FMath::Max(parsedOptions.numCachedNotifications, 1);
+	return parsedOptions;
+}
+
+bool FNotificationBackboneBenchmark::WriteResults(FString& outBasePath) const
+{
+	const FString directory = options.outputDirectory.IsEmpty() ? FPaths::Combine(FPaths::ProfilingDir(), TEXT("NotificationBackbone")) : options.outputDirectory;
+	outBasePath = FPaths::Combine(directory, FString::Printf(TEXT("NotificationBackboneBenchmark-%s"), *FDateTime::Now().ToString()));
+
+	TSharedPtr<IPlugin> plugin = IPluginManager::Get().FindPlugin(TEXT("NotificationBackbone"));
+	const FString pluginVersion = plugin.IsValid() ? plugin->GetDescriptor().VersionName : FString();
+
+	FString csv = TEXT("Scenario,Listeners,Samples,TotalMs,SamplesPerSecond,P50Us,P90Us,P99Us,MaxUs,BytesPerItem\n");
+	for (const FNotificationBackboneBenchmarkResult& result : results)
+	{
+		csv += FString::Printf(TEXT("%s,%d,%d,%.3f,%.1f,%.3f,%.3f,%.3f,%.3f,%.1f\n"), *result.scenario, result.numListeners, result.numSamples,
+			result.totalMilliseconds, result.samplesPerSecond, result.p50Microseconds, result.p90Microseconds, result.p99Microseconds,
+			result.maxMicroseconds, result.bytesPerItem);
+	}
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	writer->WriteObjectStart();
+	writer->WriteValue(TEXT("pluginVersion"), pluginVersion);
+	writer->WriteValue(TEXT("engineVersion"), FEngineVersion::Current().ToString());
+	writer->WriteValue(TEXT("platform"), FString(FPlatformProperties::PlatformName()));
+	writer->WriteValue(TEXT("iterations"), options.iterations);
+	writer->WriteValue(TEXT("cachedNotifications"), options.numCachedNotifications);
+	writer->WriteArrayStart(TEXT("results"));
+	for (const FNotificationBackboneBenchmarkResult& result : results)
+	{
+		writer->WriteObjectStart();
+		writer->WriteValue(TEXT("scenario"), result.scenario);
+		writer->WriteValue(TEXT("listeners"), result.numListeners);
+		writer->WriteValue(TEXT("samples"), result.numSamples);
+		writer->WriteValue(TEXT("totalMs"), result.totalMilliseconds);
+		writer->WriteValue(TEXT("samplesPerSecond"), result.samplesPerSecond);
+		writer->WriteValue(TEXT("p50Us"), result.p50Microseconds);
+		writer->WriteValue(TEXT("p90Us"), result.p90Microseconds);
+		writer->WriteValue(TEXT("p99Us"), result.p99Microseconds);
+		writer->WriteValue(TEXT("maxUs"), result.maxMicroseconds);
+		writer->WriteValue(TEXT("bytesPerItem"), result.bytesPerItem);
+		writer->WriteObjectEnd();
+	}
+	writer->WriteArrayEnd();
+	writer->WriteObjectEnd();
+	writer->Close();
+
+	return FFileHelper::SaveStringToFile(csv, *(outBasePath + TEXT(".csv"))) && FFileHelper::SaveStringToFile(json, *(outBasePath + TEXT(".json")));
+}
+
+#pragma region Console
+namespace NotificationBackboneConsole
+{
+	static void Benchmark(const TArray<FString>& args)
+	{
+		FNotificationBackboneBenchmark::FOptions options;
+		if (args.Num() > 0)
+		{
+			options.iterations = FMath::Max(FCString::Atoi(*args[0]), 1);
+		}
+		if (args.Num() > 1)
+		{
+			options.numCachedNotifications = FMath::Max(FCString::Atoi(*args[1]), 1);
+		}
+
+		// Runs over the next frames, the ticker lets go of it once it is done.
+		TSharedRef<FNotificationBackboneBenchmark> benchmark = MakeShareable(new FNotificationBackboneBenchmark(options));
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([benchmark](float deltaSeconds)
+		{
+			if (!benchmark->Tick())
+			{
+				return true;
+			}
+
+			FString basePath;
+			if (benchmark->WriteResults(basePath))
+			{
+				MF_LOG(Display, false, "Benchmark results written to %s.csv and .json", *basePath);
+			}
+			else
+			{
+				MF_LOG(Warning, false, "Could not write the benchmark results to %s", *basePath);
+			}
+			return false;
+		}));
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("NotificationBackbone.Benchmark"),
+		TEXT("Measures dispatch throughput and latency, writes CSV and JSON to Saved/Profiling/NotificationBackbone. [Iterations] [CachedNotifications]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Benchmark));
+}
+#pragma endregion Console
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneCapture.h"
+#include "NotificationBackboneJson.h"
+#include "NotificationBackboneDeclarations.h"
+#include "Engine/Texture2D.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+TUniquePtr<FNotificationBackboneCapture> FNotificationBackboneCapture::Create(const FString& path)
+{
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	platformFile.CreateDirectoryTree(*FPaths::GetPath(path));
+	IFileHandle* file = platformFile.OpenWrite(*path);
+	if (!file)
+	{
+		return nullptr;
+	}
+	return TUniquePtr<FNotificationBackboneCapture>(new FNotificationBackboneCapture(path, file));
+}
+
+FNotificationBackboneCapture::FNotificationBackboneCapture(const FString& in_path, IFileHandle* in_file)
+	: path(in_path), file(in_file), lastRecordSeconds(FPlatformTime::Seconds())
+{
+	buffer.Reserve(BufferSize * 2);
+
+	FMemoryWriter writer(buffer);
+	uint32 magic = Magic;
+	uint32 version = Version;
+	writer << magic << version;
+
+	wakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	thread = FRunnableThread::Create(this, TEXT("NotificationBackboneCapture"), 0, TPri_BelowNormal);
+	if (!thread)
+	{
+		// E.g. no threads on this platform. The game thread writes then.
+		MF_LOG(Warning, false, "Could not start the capture thread, writing %s on the game thread", *path);
+	}
+}
+
+FNotificationBackboneCapture::~FNotificationBackboneCapture()
+{
+	FlushBuffer();
+
+	if (thread)
+	{
+		bStopping = true;
+		wakeEvent->Trigger();
+		thread->WaitForCompletion();
+		delete thread;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(wakeEvent);
+
+	delete file;
+	MF_LOG(Log, false, "Captured %llu notifications into %s", numRecorded, *path);
+}
+
+void FNotificationBackboneCapture::Record(const FNotificationBackboneNotification& notification)
+{
+	check(IsInGameThread());
+
+	const double nowSeconds = FPlatformTime::Seconds();
+	uint32 deltaMicroseconds = (uint32)FMath::Clamp((nowSeconds - lastRecordSeconds) * 1000000.0, 0.0, (double)MAX_uint32);
+	lastRecordSeconds = nowSeconds;
+
+	FMemoryWriter writer(buffer, false, true);
+	writer.SerializeIntPacked(deltaMicroseconds);
+	SerializeName(writer, notification.feed);
+	SerializeName(writer, notification.coalescingKey);
+	SerializeName(writer, notification.routingKey);
+	uint8 priority = (uint8)notification.priority;
+	writer << priority;
+
+	FString title = notification.GetTitle().ToString();
+	FString message = notification.GetMessage().ToString();
+	FString icon = notification.icon ? notification.icon->GetPathName() : notification.softIcon.ToString();
+	FString json = notification.json.IsValid() ? notification.json->GetString() : FString();
+	writer << title << message << icon << json;
+
+	++numRecorded;
+	if (buffer.Num() >= BufferSize)
+	{
+		FlushBuffer();
+	}
+}
+
+void FNotificationBackboneCapture::SerializeName(FArchive& archive, const FName& name)
+{
+	const uint32* existingIndex = nameIndices.Find(name);
+	uint32 index = existingIndex ? *existingIndex : (uint32)nameIndices.Num();
+	archive.SerializeIntPacked(index);
+	if (!existingIndex)
+	{
+		// First time, the index is followed by the name.
+		nameIndices.Add(name, index);
+		FString nameString = name.ToString();
+		archive << nameString;
+	}
+}
+
+void FNotificationBackboneCapture::FlushBuffer()
+{
+	if (buffer.Num() == 0)
+	{
+		return;
+	}
+
+	if (!thread)
+	{
+		WriteBuffer(buffer);
+		buffer.Reset();
+		return;
+	}
+
+	fullBuffers.Enqueue(MoveTemp(buffer));
+	wakeEvent->Trigger();
+
+	if (!emptyBuffers.Dequeue(buffer))
+	{
+		// The writer still has all of them. Only until there are enough buffers in rotation.
+		buffer.Reserve(BufferSize * 2);
+	}
+}
+
+uint32 FNotificationBackboneCapture::Run()
+{
+	while (!bStopping)
+	{
+		wakeEvent->Wait();
+		WriteFullBuffers();
+	}
+	// The game thread flushed before it stopped us.
+	WriteFullBuffers();
+	return 0;
+}
+
+void FNotificationBackboneCapture::Stop()
+{
+	bStopping = true;
+	wakeEvent->Trigger();
+}
+
+void FNotificationBackboneCapture::WriteFullBuffers()
+{
+	TArray<uint8> fullBuffer;
+	while (fullBuffers.Dequeue(fullBuffer))
+	{
+		WriteBuffer(fullBuffer);
+		fullBuffer.Reset();
+		emptyBuffers.Enqueue(MoveTemp(fullBuffer));
+	}
+}
+
+void FNotificationBackboneCapture::WriteBuffer(const TArray<uint8>& fullBuffer)
+{
+	if (!file->Write(fullBuffer.GetData(), fullBuffer.Num()))
+	{
+		MF_LOG(Warning, false, "Could not write to the capture %s", *path);
+	}
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneDeferredText.h"
+#include "Misc/ScopeLock.h"
+
+FNotificationBackboneDeferredText::FNotificationBackboneDeferredText(const FTextFormat& in_format, FFormatNamedArguments&& in_arguments)
+	: format(in_format), namedArguments(MoveTemp(in_arguments)), bNamedArguments(true)
+{
+}
+
+FNotificationBackboneDeferredText::FNotificationBackboneDeferredText(const FTextFormat& in_format, FFormatOrderedArguments&& in_arguments)
+	: format(in_format), orderedArguments(MoveTemp(in_arguments)), bNamedArguments(false)
+{
+}
+
+const FText& FNotificationBackboneDeferredText::Get() const
+{
+	FScopeLock scopeLock(&lock);
+	if (!bFormatted)
+	{
+		bFormatted = true;
+		text = bNamedArguments ? FText::Format(format, namedArguments) : FText::Format(format, orderedArguments);
+		// Not needed anymore, only the text stays.
+		namedArguments.Empty();
+		orderedArguments.Empty();
+	}
+	return text;
+}
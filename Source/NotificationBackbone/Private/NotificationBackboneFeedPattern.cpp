@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneFeedPattern.h"
+
+const FName FNotificationBackboneFeedPattern::AnySegment(TEXT("*"));
+const FName FNotificationBackboneFeedPattern::AnySegments(TEXT("**"));
+
+bool FNotificationBackboneFeedPattern::IsPattern(const FName& name)
+{
+	return name.ToString().Contains(TEXT("*"));
+}
+
+void FNotificationBackboneFeedPattern::Split(const FName& name, TArray<FName>& outSegments)
+{
+	TArray<FString> segments;
+	name.ToString().ParseIntoArray(segments, TEXT("."));
+
+	outSegments.Reset(segments.Num());
+	for (const FString& segment : segments)
+	{
+		outSegments.Add(FName(*segment));
+	}
+}
+
+bool FNotificationBackboneFeedPattern::IsValid(const TArray<FName>& pattern)
+{
+	const int32 anySegmentsIndex = pattern.IndexOfByKey(AnySegments);
+	return anySegmentsIndex == INDEX_NONE || anySegmentsIndex == pattern.Num() - 1;
+}
+
+bool FNotificationBackboneFeedPattern::Matches(const TArray<FName>& pattern, const TArray<FName>& feed)
+{
+	for (int32 index = 0; index < pattern.Num(); ++index)
+	{
+		if (pattern[index] == AnySegments)
+		{
+			// At least one segment left.
+			return index == pattern.Num() - 1 && feed.Num() > index;
+		}
+		if (index >= feed.Num() || (pattern[index] != AnySegment && pattern[index] != feed[index]))
+		{
+			return false;
+		}
+	}
+	return pattern.Num() == feed.Num();
+}
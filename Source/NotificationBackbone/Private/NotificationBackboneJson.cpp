@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneJson.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "NotificationBackboneDeclarations.h"
+
+FNotificationBackboneJsonPayload::FNotificationBackboneJsonPayload(const FString& in_jsonString)
+	: jsonString(in_jsonString), bParsed(false), bHasString(true)
+{
+}
+
+FNotificationBackboneJsonPayload::FNotificationBackboneJsonPayload(FString&& in_jsonString)
+	: jsonString(MoveTemp(in_jsonString)), bParsed(false), bHasString(true)
+{
+}
+
+FNotificationBackboneJsonPayload::FNotificationBackboneJsonPayload(const TSharedRef<FJsonObject>& in_jsonObject)
+	: jsonObject(in_jsonObject), bParsed(true), bHasString(false)
+{
+}
+
+TSharedPtr<FJsonObject> FNotificationBackboneJsonPayload::GetObject() const
+{
+	FScopeLock scopeLock(&lock);
+	if (!bParsed)
+	{
+		bParsed = true;
+		TSharedRef<TJsonReader<>> reader = TJsonReaderFactory<>::Create(jsonString);
+		if (!FJsonSerializer::Deserialize(reader, jsonObject))
+		{
+			MF_LOG(Warning, false, "Notification JSON payload is no valid JSON object: %s", *reader->GetErrorMessage());
+			jsonObject.Reset();
+		}
+	}
+	return jsonObject;
+}
+
+FString FNotificationBackboneJsonPayload::GetString() const
+{
+	FScopeLock scopeLock(&lock);
+	if (!bHasString && jsonObject.IsValid())
+	{
+		TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonString);
+		FJsonSerializer::Serialize(jsonObject.ToSharedRef(), writer);
+		bHasString = true;
+	}
+	return jsonString;
+}
+
+TSharedPtr<FJsonObject> FNotificationBackboneJsonPayload::ParseObject() const
+{
+	TSharedPtr<FJsonObject> parsedObject;
+	TSharedRef<TJsonReader<>> reader = TJsonReaderFactory<>::Create(GetString());
+	if (!FJsonSerializer::Deserialize(reader, parsedObject))
+	{
+		MF_LOG(Warning, false, "Notification JSON payload is no valid JSON object: %s", *reader->GetErrorMessage());
+		return nullptr;
+	}
+	return parsedObject;
+}
+
+TSharedPtr<FJsonValue> FNotificationBackboneJsonPayload::FindField(const FString& path) const
+{
+	TSharedPtr<FJsonObject> current = GetObject();
+	if (!current.IsValid())
+	{
+		return nullptr;
+	}
+
+	TArray<FString> parts;
+	path.ParseIntoArray(parts, TEXT("."));
+	if (parts.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	for (int32 index = 0; index < parts.Num() - 1; ++index)
+	{
+		const TSharedPtr<FJsonObject>* child = nullptr;
+		if (!current->TryGetObjectField(parts[index], child))
+		{
+			return nullptr;
+		}
+		current = *child;
+	}
+	return current->TryGetField(parts.Last());
+}
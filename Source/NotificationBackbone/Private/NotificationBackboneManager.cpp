@@ -1,81 +1,1323 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "NotificationBackboneManager.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
 
 
-void FNotificationBackboneManager::RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed)
+void FNotificationBackboneManager::RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed, const FNotificationBackboneListenerOptions& options)
 {
-	CreateNotificationFeedWhenNotExists(feed);
-	(*notificationFeeds.Find(feed))->AddListener(listener);
+	if (FNotificationBackboneFeedPattern::IsPattern(feed))
+	{
+		FPatternSubscription subscription;
+		subscription.pattern = feed;
+		subscription.raw = listener;
+		subscription.key = &listener.Get();
+		subscription.options = options;
+		RegisterPatternSubscription(subscription);
+		return;
+	}
+
+	int32 slotIndex = CreateNotificationFeedWhenNotExists(feed);
+	TSharedPtr<FNotificationBackboneNotificationFeed> pfeed = feedSlots[slotIndex].feed;
+	pfeed->AddListener(listener, options);
+	RetireNotificationFeedWhenEmpty(slotIndex);
+}
+
+void FNotificationBackboneManager::RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FNotificationFeedHandle& feed, const FNotificationBackboneListenerOptions& options)
+{
+	if (FNotificationBackboneFeedPattern::IsPattern(feed.feed))
+	{
+		// A pattern is no feed, there is nothing to resolve.
+		RegisterForNotifications(listener, feed.feed, options);
+		return;
+	}
+
+	int32 slotIndex = ResolveFeedSlot(feed, true);
+	TSharedPtr<FNotificationBackboneNotificationFeed> pfeed = feedSlots[slotIndex].feed;
+	pfeed->AddListener(listener, options);
+	RetireNotificationFeedWhenEmpty(slotIndex);
 }
 
 void FNotificationBackboneManager::UnregisterFromNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed)
 {
-	TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = notificationFeeds.Find(feed);
-	if (pfeed)
+	if (FNotificationBackboneFeedPattern::IsPattern(feed))
+	{
+		UnregisterPatternSubscription(feed, &listener.Get());
+		return;
+	}
+
+	const int32* slotIndex = feedSlotIndices.Find(feed);
+	if (slotIndex)
+	{
+		const int32 index = *slotIndex;
+		feedSlots[index].feed->RemoveListener(listener);
+		RetireNotificationFeedWhenEmpty(index);
+	}
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotification(const FNotificationBackboneNotification& notification)
+{
+	if (!IsInGameThread())
+	{
+		return DispatchNotification(MakeNotificationBackboneNotification(notification));
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_DispatchNotification);
+	const int32 slotIndex = CreateNotificationFeedWhenNotExists(notification.feed);
+	return DispatchNotificationCopy(slotIndex, notification);
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotification(const FNotificationBackboneNotificationRef& notification)
+{
+	if (!IsInGameThread())
+	{
+		incomingNotifications.Enqueue(notification);
+		return ENotificationBackboneDispatchResult::Deferred;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_DispatchNotification);
+	return DispatchNotificationInternal(CreateNotificationFeedWhenNotExists(notification->feed), notification);
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotification(FNotificationFeedHandle& feed, const FNotificationBackboneNotification& notification)
+{
+	if (notification.feed != feed.feed || !IsInGameThread())
+	{
+		// Handles must only be resolved on the game thread, the other path takes care of it.
+		return DispatchNotification(feed, MakeNotificationBackboneNotification(notification));
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_DispatchNotification);
+	const int32 slotIndex = ResolveFeedSlot(feed, true);
+	return DispatchNotificationCopy(slotIndex, notification);
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotification(FNotificationFeedHandle& feed, const FNotificationBackboneNotificationRef& notification)
+{
+	if (notification->feed != feed.feed)
+	{
+		// The handle decides. Rare case, only when the producer did not fill in the feed.
+		FNotificationBackboneNotification routedNotification = *notification;
+		routedNotification.feed = feed.feed;
+		return DispatchNotification(feed, MakeNotificationBackboneNotification(MoveTemp(routedNotification)));
+	}
+
+	if (!IsInGameThread())
+	{
+		// Handles must only be resolved on the game thread. The inbox goes by name.
+		incomingNotifications.Enqueue(notification);
+		return ENotificationBackboneDispatchResult::Deferred;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_DispatchNotification);
+	return DispatchNotificationInternal(ResolveFeedSlot(feed, true), notification);
+}
+
+void FNotificationBackboneManager::FlushIncomingNotifications()
+{
+	check(IsInGameThread());
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_FlushIncomingNotifications);
+
+	// Only take what is there right now. Whatever comes in while we drain waits for the next flush.
+	uint32 numToDrain = incomingNotifications.Num();
+	FNotificationBackboneNotificationPtr notification;
+	while (numToDrain > 0 && incomingNotifications.Dequeue(notification))
+	{
+		DispatchNotificationInternal(CreateNotificationFeedWhenNotExists(notification->feed), notification.ToSharedRef());
+		--numToDrain;
+	}
+
+	// Listeners of the channels may create channels meanwhile.
+	for (int32 index = 0; index < channels.Num(); ++index)
+	{
+		channels[index].flushIncomingPayloads(channels[index].channel.Get());
+	}
+	flushIncomingNotificationsDelegate.Broadcast();
+}
+
+FNotificationBackboneNotificationRef FNotificationBackboneManager::MakeNotificationForFeed(int32 slotIndex, const FNotificationBackboneNotification& notification) const
+{
+	TSharedRef<FNotificationBackboneNotification, ESPMode::ThreadSafe> sharedNotification = MakeShared<FNotificationBackboneNotification, ESPMode::ThreadSafe>(notification);
+	// Nobody else has it yet. Stamping it here saves the feed a copy for its UObject listeners.
+	sharedNotification->feedDispatchDelay = feedSlots[slotIndex].feed->settings.dispatchDelay;
+	return sharedNotification;
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotificationCopy(int32 slotIndex, const FNotificationBackboneNotification& notification)
+{
+	// Most broadcasts into feeds nobody listens to end here, before anything got allocated. A capture wants to see them.
+	if (!capture.IsValid() && feedSlots[slotIndex].feed->DropWithoutListeners())
+	{
+		RetireNotificationFeedWhenEmpty(slotIndex);
+		return ENotificationBackboneDispatchResult::DroppedNoListeners;
+	}
+	return DispatchNotificationInternal(slotIndex, MakeNotificationForFeed(slotIndex, notification));
+}
+
+ENotificationBackboneDispatchResult FNotificationBackboneManager::DispatchNotificationInternal(int32 slotIndex, const FNotificationBackboneNotificationRef& notification)
+{
+	if (capture.IsValid())
+	{
+		capture->Record(*notification);
+	}
+
+	// Keep the feed alive, a listener might get rid of it.
+	TSharedPtr<FNotificationBackboneNotificationFeed> feed = feedSlots[slotIndex].feed;
+	ENotificationBackboneDispatchResult result = feed->EnqueueNotification(notification);
+	RetireNotificationFeedWhenEmpty(slotIndex);
+	return result;
+}
+
+bool FNotificationBackboneManager::StartCapture(const FString& path)
+{
+	check(IsInGameThread());
+	StopCapture();
+
+	capture = FNotificationBackboneCapture::Create(path);
+	if (!capture.IsValid())
 	{
-		(*pfeed)->RemoveListener(listener);
-		RemoveNotificationFeedWhenEmpty(feed);
+		MF_LOG(Warning, true, "Could not create the capture %s", *path);
+		return false;
 	}
+	MF_LOG(Log, false, "Capturing notifications into %s", *path);
+	return true;
 }
 
-void FNotificationBackboneManager::DispatchNotification(const FNotificationBackboneNotification& notification)
+void FNotificationBackboneManager::StopCapture()
 {
-	CreateNotificationFeedWhenNotExists(notification.feed);
-	(*notificationFeeds.Find(notification.feed))->EnqueueNotification(notification);
-	RemoveNotificationFeedWhenEmpty(notification.feed);
+	// Writes what is left.
+	capture.Reset();
 }
 
 bool FNotificationBackboneManager::ClearNotificationFeedNotifications(const FName& feed)
 {
-	TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = notificationFeeds.Find(feed);
-	if (pfeed)
+	const int32* slotIndex = feedSlotIndices.Find(feed);
+	if (slotIndex)
 	{
-		(*pfeed)->ClearNotifications();
-		RemoveNotificationFeedWhenEmpty(feed);
+		const int32 index = *slotIndex;
+		feedSlots[index].feed->ClearNotifications();
+		RetireNotificationFeedWhenEmpty(index);
 		return true;
 	}
 	return false;
 }
 
-void FNotificationBackboneManager::RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed)
+void FNotificationBackboneManager::SetNotificationFeedMergeFunction(const FName& feed, const FOnNotificationBackboneMerge& mergeFunction)
+{
+	if (mergeFunction.IsBound())
+	{
+		feedMergeFunctions.Add(feed, mergeFunction);
+	}
+	else
+	{
+		feedMergeFunctions.Remove(feed);
+	}
+
+	FNotificationBackboneNotificationFeed* pfeed = GetNotificationFeed(feed);
+	if (pfeed)
+	{
+		pfeed->mergeFunction = mergeFunction;
+	}
+}
+
+void FNotificationBackboneManager::ScheduleFeedDispatch(const FNotificationFeedHandle& feed, float delaySeconds)
+{
+	check(IsHandleValid(feed));
+
+	FScheduledFeedDispatch scheduled;
+	scheduled.dueSeconds = schedulerSeconds + delaySeconds;
+	scheduled.order = scheduleOrder++;
+	scheduled.slotIndex = feed.index;
+	scheduled.generation = feed.generation;
+	scheduledFeeds.HeapPush(scheduled);
+}
+
+void FNotificationBackboneManager::ScheduleFeedDispatchNextFrame(const FNotificationFeedHandle& feed)
+{
+	check(IsHandleValid(feed));
+	nextFrameFeeds.Add(feed);
+}
+
+void FNotificationBackboneManager::BeginFeedDispatch(const FName& feed)
+{
+	if (activeFeedDispatches++ == 0 && !bRunningCascade)
+	{
+		cascadeRootFeed = feed;
+	}
+}
+
+void FNotificationBackboneManager::EndFeedDispatch()
+{
+	check(activeFeedDispatches > 0);
+	if (--activeFeedDispatches == 0 && !bRunningCascade && cascade.Num() > 0)
+	{
+		RunCascade();
+	}
+}
+
+void FNotificationBackboneManager::DeferFeedDispatch(FNotificationBackboneNotificationFeed& feed)
+{
+	check(IsInGameThread() && !feed.bCascadePending);
+
+	const int32 depth = currentCascadeEntry == INDEX_NONE ? 1 : cascade[currentCascadeEntry].depth + 1;
+	const int32 maxCascadeDepth = UNotificationBackboneSettings::Get()->maxCascadeDepth;
+	if (maxCascadeDepth > 0 && depth > maxCascadeDepth)
+	{
+		MF_LOG(Warning, false, "Notification cascade deeper than %d, %s goes on the next frame: %s",
+			maxCascadeDepth, *feed.GetFeedName().ToString(), *DescribeCascade(currentCascadeEntry, feed.GetFeedName()));
+		// Scheduled, so nothing queues it a second time. Delayed feeds wait their delay, a loop through them stays at their pace.
+		feed.bIsScheduled = true;
+		if (feed.IsDelayed())
+		{
+			ScheduleFeedDispatch(feed.selfHandle, feed.settings.dispatchDelay);
+		}
+		else
+		{
+			ScheduleFeedDispatchNextFrame(feed.selfHandle);
+		}
+		return;
+	}
+
+	feed.bCascadePending = true;
+	FCascadeEntry entry;
+	entry.feed = feed.selfHandle;
+	entry.parent = currentCascadeEntry;
+	entry.depth = depth;
+	cascade.Add(entry);
+}
+
+void FNotificationBackboneManager::RunCascade()
+{
+	bRunningCascade = true;
+	// Breadth-first, feeds deferred meanwhile go to the back.
+	for (int32 index = 0; index < cascade.Num(); ++index)
+	{
+		// Copy, the list grows while we dispatch.
+		const FNotificationFeedHandle handle = cascade[index].feed;
+		if (!IsHandleValid(handle))
+		{
+			continue;
+		}
+
+		// Keep the feed alive, a listener might get rid of it.
+		TSharedPtr<FNotificationBackboneNotificationFeed> feed = feedSlots[handle.index].feed;
+		feed->bCascadePending = false;
+		currentCascadeEntry = index;
+		feed->StartDispatching();
+		RetireNotificationFeedWhenEmpty(handle.index);
+	}
+	cascade.Reset();
+	currentCascadeEntry = INDEX_NONE;
+	bRunningCascade = false;
+}
+
+FString FNotificationBackboneManager::DescribeCascade(int32 entryIndex, const FName& deferredFeed) const
+{
+	// Deferred feed first, root last.
+	TArray<FName> feeds;
+	feeds.Add(deferredFeed);
+	for (int32 index = entryIndex; index != INDEX_NONE; index = cascade[index].parent)
+	{
+		feeds.Add(cascade[index].feed.feed);
+	}
+	feeds.Add(cascadeRootFeed);
+
+	int32 first = feeds.Num() - 1;
+	for (int32 index = 1; index < feeds.Num(); ++index)
+	{
+		if (feeds[index] == deferredFeed)
+		{
+			first = index;
+			break;
+		}
+	}
+
+	FString description;
+	for (int32 index = first; index >= 0; --index)
+	{
+		description += feeds[index].ToString();
+		if (index > 0)
+		{
+			description += TEXT(" -> ");
+		}
+	}
+	return description;
+}
+
+bool FNotificationBackboneManager::HasDispatchBudgetLeft() const
+{
+	const UNotificationBackboneSettings* backboneSettings = UNotificationBackboneSettings::Get();
+	if (backboneSettings->maxDispatchesPerFrame > 0 && frameDispatchCount >= backboneSettings->maxDispatchesPerFrame)
+	{
+		return false;
+	}
+
+	if (backboneSettings->maxDispatchMicrosecondsPerFrame > 0.f && frameDispatchCycles >= MicrosecondsToCycles(backboneSettings->maxDispatchMicrosecondsPerFrame))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void FNotificationBackboneManager::DispatchScheduledFeeds()
+{
+	// What got carried over from the last frame goes first. Feeds that run out of budget again add themselves for the next frame.
+	TArray<FNotificationFeedHandle> carriedOverFeeds = MoveTemp(nextFrameFeeds);
+	nextFrameFeeds.Reset();
+	for (const FNotificationFeedHandle& feed : carriedOverFeeds)
+	{
+		RunScheduledFeed(feed.index, feed.generation, schedulerSeconds);
+	}
+
+	while (scheduledFeeds.Num() > 0 && scheduledFeeds.HeapTop().dueSeconds <= schedulerSeconds && HasDispatchBudgetLeft())
+	{
+		FScheduledFeedDispatch scheduled;
+		scheduledFeeds.HeapPop(scheduled, false);
+		RunScheduledFeed(scheduled.slotIndex, scheduled.generation, scheduled.dueSeconds);
+	}
+}
+
+void FNotificationBackboneManager::RunScheduledFeed(int32 slotIndex, uint32 generation, double dueSeconds)
+{
+	FNotificationFeedSlot& slot = feedSlots[slotIndex];
+	if (slot.generation != generation || !slot.feed.IsValid())
+	{
+		return;
+	}
+
+	// Keep the feed alive, a listener might get rid of it.
+	TSharedPtr<FNotificationBackboneNotificationFeed> feed = slot.feed;
+	float nextDelay = 0.f;
+	if (feed->OnScheduledDispatch(nextDelay))
+	{
+		if (nextDelay > 0.f)
+		{
+			// Next one is due one delay after this one was due, not after now. That way long frames catch up.
+			FScheduledFeedDispatch scheduled;
+			scheduled.dueSeconds = dueSeconds + nextDelay;
+			scheduled.order = scheduleOrder++;
+			scheduled.slotIndex = slotIndex;
+			scheduled.generation = generation;
+			scheduledFeeds.HeapPush(scheduled);
+		}
+		else
+		{
+			ScheduleFeedDispatchNextFrame(feed->selfHandle);
+		}
+	}
+	RetireNotificationFeedWhenEmpty(slotIndex);
+}
+
+FNotificationFeedHandle FNotificationBackboneManager::ResolveNotificationFeedHandle(const FName& feed) const
+{
+	FNotificationFeedHandle handle;
+	handle.feed = feed;
+
+	const int32* slotIndex = feedSlotIndices.Find(feed);
+	if (slotIndex)
+	{
+		handle.index = *slotIndex;
+		handle.generation = feedSlots[*slotIndex].generation;
+	}
+	return handle;
+}
+
+void FNotificationBackboneManager::RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed, const FNotificationBackboneListenerOptions& options)
+{
+	if (FNotificationBackboneFeedPattern::IsPattern(feed))
+	{
+		if (listenerObject.GetObject())
+		{
+			FPatternSubscription subscription;
+			subscription.pattern = feed;
+			subscription.object = listenerObject.GetObject();
+			subscription.key = listenerObject.GetObject();
+			subscription.options = options;
+			RegisterPatternSubscription(subscription);
+		}
+		return;
+	}
+
+	int32 slotIndex = CreateNotificationFeedWhenNotExists(feed);
+	TSharedPtr<FNotificationBackboneNotificationFeed> pfeed = feedSlots[slotIndex].feed;
+	pfeed->AddListenerObject(listenerObject, options);
+	RetireNotificationFeedWhenEmpty(slotIndex);
+}
+
+void FNotificationBackboneManager::RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FNotificationFeedHandle& feed, const FNotificationBackboneListenerOptions& options)
 {
-	CreateNotificationFeedWhenNotExists(feed);
-	(*notificationFeeds.Find(feed))->AddListenerObject(listenerObject);
+	if (FNotificationBackboneFeedPattern::IsPattern(feed.feed))
+	{
+		// A pattern is no feed, there is nothing to resolve.
+		RegisterForNotificationsUObject(listenerObject, feed.feed, options);
+		return;
+	}
+
+	int32 slotIndex = ResolveFeedSlot(feed, true);
+	TSharedPtr<FNotificationBackboneNotificationFeed> pfeed = feedSlots[slotIndex].feed;
+	pfeed->AddListenerObject(listenerObject, options);
+	RetireNotificationFeedWhenEmpty(slotIndex);
 }
 
 void FNotificationBackboneManager::UnregisterFromNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed)
 {
-	TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = notificationFeeds.Find(feed);
-	if (pfeed)
+	if (FNotificationBackboneFeedPattern::IsPattern(feed))
+	{
+		UnregisterPatternSubscription(feed, listenerObject.GetObject());
+		return;
+	}
+
+	const int32* slotIndex = feedSlotIndices.Find(feed);
+	if (slotIndex)
+	{
+		const int32 index = *slotIndex;
+		feedSlots[index].feed->RemoveListenerObject(listenerObject);
+		RetireNotificationFeedWhenEmpty(index);
+	}
+}
+
+int32 FNotificationBackboneManager::CreateNotificationFeedWhenNotExists(const FName& feed)
+{
+	const int32* existingSlotIndex = feedSlotIndices.Find(feed);
+	if (existingSlotIndex)
+	{
+		return *existingSlotIndex;
+	}
+
+	int32 slotIndex;
+	if (freeFeedSlots.Num() > 0)
+	{
+		slotIndex = freeFeedSlots.Pop(false);
+	}
+	else
 	{
-		(*pfeed)->RemoveListenerObject(listenerObject);
-		RemoveNotificationFeedWhenEmpty(feed);
+		slotIndex = feedSlots.AddDefaulted();
 	}
+
+	if (recycledFeeds.Num() > 0)
+	{
+		feedSlots[slotIndex].feed = recycledFeeds.Pop(false);
+		feedSlots[slotIndex].feed->ResetForFeed(feed);
+	}
+	else
+	{
+		feedSlots[slotIndex].feed = MakeShareable(new FNotificationBackboneNotificationFeed(feed));
+	}
+
+	FNotificationBackboneNotificationFeed& newFeed = *feedSlots[slotIndex].feed;
+	newFeed.selfHandle.feed = feed;
+	newFeed.selfHandle.index = slotIndex;
+	newFeed.selfHandle.generation = feedSlots[slotIndex].generation;
+
+	const FOnNotificationBackboneMerge* mergeFunction = feedMergeFunctions.Find(feed);
+	if (mergeFunction)
+	{
+		feedSlots[slotIndex].feed->mergeFunction = *mergeFunction;
+	}
+
+	feedSlotIndices.Add(feed, slotIndex);
+	ApplyPatternSubscriptions(slotIndex);
+	return slotIndex;
 }
 
-void FNotificationBackboneManager::CreateNotificationFeedWhenNotExists(const FName& feed)
+void FNotificationBackboneManager::RegisterPatternSubscription(const FPatternSubscription& subscription)
 {
-	if (!notificationFeeds.Contains(feed))
+	TArray<FName> patternSegments;
+	FNotificationBackboneFeedPattern::Split(subscription.pattern, patternSegments);
+	if (!FNotificationBackboneFeedPattern::IsValid(patternSegments))
+	{
+		MF_LOG(Warning, true, "Invalid feed pattern, \"**\" is only allowed at the end: %s", *subscription.pattern.ToString());
+		return;
+	}
+
+	const int32 nodeIndex = FindPatternNode(patternSegments, true);
+	FPatternTrieNode& node = patternTrie[nodeIndex];
+	TArray<int32>& nodeSubscriptions = patternSegments.Last() == FNotificationBackboneFeedPattern::AnySegments ? node.deepSubscriptions : node.subscriptions;
+	const int32* existing = nodeSubscriptions.FindByPredicate([this, &subscription](int32 subscriptionIndex)
+	{
+		return patternSubscriptions[subscriptionIndex].key == subscription.key;
+	});
+	if (existing)
+	{
+		// Registered for the same pattern again, takes the new options.
+		patternSubscriptions[*existing] = subscription;
+	}
+	else
 	{
-		notificationFeeds.Add(feed, TSharedRef<FNotificationBackboneNotificationFeed>(new FNotificationBackboneNotificationFeed(feed)));
+		nodeSubscriptions.Add(patternSubscriptions.Add(subscription));
+	}
+
+	// The feeds that exist already get the listener now, the others when they get created.
+	TArray<FName> feedSegments;
+	for (int32 slotIndex = 0; slotIndex < feedSlots.Num(); ++slotIndex)
+	{
+		FNotificationFeedSlot& slot = feedSlots[slotIndex];
+		if (!slot.feed.IsValid())
+		{
+			continue;
+		}
+
+		FNotificationBackboneFeedPattern::Split(slot.feed->GetFeedName(), feedSegments);
+		if (FNotificationBackboneFeedPattern::Matches(patternSegments, feedSegments))
+		{
+			TSharedPtr<FNotificationBackboneNotificationFeed> feed = slot.feed;
+			ApplyPatternSubscription(subscription, *feed);
+			RetireNotificationFeedWhenEmpty(slotIndex);
+		}
 	}
 }
 
-void FNotificationBackboneManager::RemoveNotificationFeedWhenEmpty(const FName& feed)
+void FNotificationBackboneManager::UnregisterPatternSubscription(const FName& pattern, const void* key)
 {
-	TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = notificationFeeds.Find(feed);
-	if (pfeed)
+	TArray<FName> patternSegments;
+	FNotificationBackboneFeedPattern::Split(pattern, patternSegments);
+	const int32 nodeIndex = FindPatternNode(patternSegments, false);
+	if (nodeIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FPatternTrieNode& node = patternTrie[nodeIndex];
+	TArray<int32>& nodeSubscriptions = patternSegments.Last() == FNotificationBackboneFeedPattern::AnySegments ? node.deepSubscriptions : node.subscriptions;
+	const int32 position = nodeSubscriptions.IndexOfByPredicate([this, key](int32 subscriptionIndex)
+	{
+		return patternSubscriptions[subscriptionIndex].key == key;
+	});
+	if (position == INDEX_NONE)
+	{
+		return;
+	}
+	patternSubscriptions.RemoveAt(nodeSubscriptions[position]);
+	nodeSubscriptions.RemoveAtSwap(position, 1, false);
+
+	// Feeds another pattern of the listener matches as well keep the listener, e.g. "Combat.*" and "Combat.**".
+	// Also unsubscribes the listener when it registered for a matching feed directly, a listener is only there once per feed.
+	TArray<FName> feedSegments;
+	TArray<int32> matchingSubscriptions;
+	for (int32 slotIndex = 0; slotIndex < feedSlots.Num(); ++slotIndex)
 	{
-		if (!(*pfeed)->GetDoesHaveListeners() && !(*pfeed)->GetDoesHaveNotifications())
+		FNotificationFeedSlot& slot = feedSlots[slotIndex];
+		if (!slot.feed.IsValid())
 		{
-			notificationFeeds.Remove(feed);
+			continue;
 		}
+
+		FNotificationBackboneFeedPattern::Split(slot.feed->GetFeedName(), feedSegments);
+		if (!FNotificationBackboneFeedPattern::Matches(patternSegments, feedSegments))
+		{
+			continue;
+		}
+
+		matchingSubscriptions.Reset();
+		CollectPatternSubscriptions(0, feedSegments, 0, matchingSubscriptions);
+		const int32* remaining = matchingSubscriptions.FindByPredicate([this, key](int32 subscriptionIndex)
+		{
+			return patternSubscriptions[subscriptionIndex].key == key;
+		});
+
+		TSharedPtr<FNotificationBackboneNotificationFeed> feed = slot.feed;
+		if (remaining)
+		{
+			// Takes the options of the pattern that is left.
+			ApplyPatternSubscription(patternSubscriptions[*remaining], *feed);
+		}
+		else
+		{
+			feed->RemoveListenerEntry(key);
+		}
+		RetireNotificationFeedWhenEmpty(slotIndex);
 	}
 }
 
-void FNotificationBackboneManager::ClearNotificationFeeds()
+void FNotificationBackboneManager::ApplyPatternSubscription(const FPatternSubscription& subscription, FNotificationBackboneNotificationFeed& feed)
 {
-	MF_LOG(Log, false, "Clearing notification listeners.");
-	notificationFeeds.Empty();
+	if (UObject* object = subscription.object.Get())
+	{
+		feed.AddListenerObject(TScriptInterface<INotificationBackboneListener>(object), subscription.options);
+	}
+	else if (TSharedPtr<INotificationBackboneListenerRaw> raw = subscription.raw.Pin())
+	{
+		feed.AddListener(raw.ToSharedRef(), subscription.options);
+	}
+}
+
+void FNotificationBackboneManager::ApplyPatternSubscriptions(int32 slotIndex)
+{
+	if (patternSubscriptions.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FName> feedSegments;
+	FNotificationBackboneFeedPattern::Split(feedSlots[slotIndex].feed->GetFeedName(), feedSegments);
+
+	TArray<int32> matchingSubscriptions;
+	CollectPatternSubscriptions(0, feedSegments, 0, matchingSubscriptions);
+	for (int32 subscriptionIndex : matchingSubscriptions)
+	{
+		ApplyPatternSubscription(patternSubscriptions[subscriptionIndex], *feedSlots[slotIndex].feed);
+	}
+}
+
+void FNotificationBackboneManager::CollectPatternSubscriptions(int32 nodeIndex, const TArray<FName>& feedSegments, int32 segment, TArray<int32>& outSubscriptions) const
+{
+	if (!patternTrie.IsValidIndex(nodeIndex))
+	{
+		return;
+	}
+
+	const FPatternTrieNode& node = patternTrie[nodeIndex];
+	if (segment == feedSegments.Num())
+	{
+		outSubscriptions.Append(node.subscriptions);
+		return;
+	}
+
+	// At least one segment left, "**" matches.
+	outSubscriptions.Append(node.deepSubscriptions);
+
+	// A pattern is a single path through the trie, so no subscription gets collected twice.
+	if (const int32* child = node.children.Find(feedSegments[segment]))
+	{
+		CollectPatternSubscriptions(*child, feedSegments, segment + 1, outSubscriptions);
+	}
+	if (const int32* anyChild = node.children.Find(FNotificationBackboneFeedPattern::AnySegment))
+	{
+		CollectPatternSubscriptions(*anyChild, feedSegments, segment + 1, outSubscriptions);
+	}
+}
+
+int32 FNotificationBackboneManager::FindPatternNode(const TArray<FName>& patternSegments, bool bCreate)
+{
+	if (patternTrie.Num() == 0)
+	{
+		if (!bCreate)
+		{
+			return INDEX_NONE;
+		}
+		patternTrie.AddDefaulted();
+	}
+
+	int32 nodeIndex = 0;
+	for (const FName& segment : patternSegments)
+	{
+		if (segment == FNotificationBackboneFeedPattern::AnySegments)
+		{
+			break;
+		}
+
+		const int32* child = patternTrie[nodeIndex].children.Find(segment);
+		if (child)
+		{
+			nodeIndex = *child;
+		}
+		else if (bCreate)
+		{
+			const int32 childIndex = patternTrie.AddDefaulted();
+			patternTrie[nodeIndex].children.Add(segment, childIndex);
+			nodeIndex = childIndex;
+		}
+		else
+		{
+			return INDEX_NONE;
+		}
+	}
+	return nodeIndex;
+}
+
+void FNotificationBackboneManager::RetireNotificationFeedWhenEmpty(int32 slotIndex)
+{
+	FNotificationFeedSlot& slot = feedSlots[slotIndex];
+	if (!slot.feed.IsValid())
+	{
+		return;
+	}
+
+	if (slot.bIsIdle)
+	{
+		UnlinkIdleFeedSlot(slotIndex);
+	}
+
+	if (!slot.feed->GetDoesHaveListeners() && !slot.feed->GetDoesHaveNotifications())
+	{
+		// Back of the list, it got used just now.
+		slot.idleSinceSeconds = FPlatformTime::Seconds();
+		LinkIdleFeedSlot(slotIndex);
+	}
+}
+
+void FNotificationBackboneManager::EvictIdleNotificationFeeds()
+{
+	const UNotificationBackboneSettings* backboneSettings = UNotificationBackboneSettings::Get();
+	const double evictBeforeSeconds = FPlatformTime::Seconds() - backboneSettings->idleFeedGracePeriod;
+
+	while (idleFeedsHead != INDEX_NONE
+		&& (numIdleFeeds > backboneSettings->maxIdleFeeds || feedSlots[idleFeedsHead].idleSinceSeconds <= evictBeforeSeconds))
+	{
+		const FNotificationBackboneNotificationFeed& feed = *feedSlots[idleFeedsHead].feed;
+		if (feed.GetDoesHaveListeners() || feed.GetDoesHaveNotifications())
+		{
+			// Got used by someone going to the feed directly. It is no longer idle, destroying it would lose its listeners.
+			UnlinkIdleFeedSlot(idleFeedsHead);
+			continue;
+		}
+		DestroyNotificationFeed(idleFeedsHead);
+	}
+}
+
+void FNotificationBackboneManager::DestroyNotificationFeed(int32 slotIndex)
+{
+	FNotificationFeedSlot& slot = feedSlots[slotIndex];
+	check(slot.feed.IsValid());
+
+	if (slot.bIsIdle)
+	{
+		UnlinkIdleFeedSlot(slotIndex);
+	}
+
+	feedSlotIndices.Remove(slot.feed->GetFeedName());
+	RetireFeedCounters(*slot.feed);
+
+	// Only empty feeds can be reused, everything else goes away with its notifications.
+	if (!slot.feed->GetDoesHaveListeners() && !slot.feed->GetDoesHaveNotifications()
+		&& recycledFeeds.Num() < UNotificationBackboneSettings::Get()->maxIdleFeeds)
+	{
+		recycledFeeds.Add(slot.feed);
+	}
+
+	slot.feed.Reset();
+	++slot.generation;
+	freeFeedSlots.Add(slotIndex);
+}
+
+const FName FNotificationBackboneManager::RetiredFeedsName(TEXT("NotificationBackbone.RetiredFeeds"));
+
+void FNotificationBackboneManager::RetireFeedCounters(const FNotificationBackboneNotificationFeed& feed)
+{
+	const FNotificationBackboneFeedCounters& counters = feed.GetCounters();
+	if (counters.numEnqueued != 0 || counters.numCoalesced != 0 || counters.numDroppedNoListeners != 0 || counters.numDroppedOverflow != 0)
+	{
+		const FName feedName = feed.GetFeedName();
+		if (FNotificationBackboneFeedCounters* retiredCounters = retiredFeedCounters.Find(feedName))
+		{
+			retiredCounters->Append(counters);
+			return;
+		}
+
+		// Oldest first, into the common entry.
+		const int32 maxRetiredFeedStats = UNotificationBackboneSettings::Get()->maxRetiredFeedStats;
+		while (retiredFeedNames.Num() > 0 && retiredFeedNames.Num() >= maxRetiredFeedStats)
+		{
+			const FNotificationBackboneFeedCounters oldestCounters = retiredFeedCounters.FindAndRemoveChecked(retiredFeedNames[0]);
+			retiredFeedNames.RemoveAt(0, 1, false);
+			retiredFeedCounters.FindOrAdd(RetiredFeedsName).Append(oldestCounters);
+		}
+
+		if (maxRetiredFeedStats > 0)
+		{
+			retiredFeedCounters.Add(feedName, counters);
+			retiredFeedNames.Add(feedName);
+		}
+		else
+		{
+			retiredFeedCounters.FindOrAdd(RetiredFeedsName).Append(counters);
+		}
+	}
+}
+
+void FNotificationBackboneManager::LinkIdleFeedSlot(int32 slotIndex)
+{
+	FNotificationFeedSlot& slot = feedSlots[slotIndex];
+	check(!slot.bIsIdle);
+
+	slot.bIsIdle = true;
+	slot.idlePrev = idleFeedsTail;
+	slot.idleNext = INDEX_NONE;
+	if (idleFeedsTail != INDEX_NONE)
+	{
+		feedSlots[idleFeedsTail].idleNext = slotIndex;
+	}
+	else
+	{
+		idleFeedsHead = slotIndex;
+	}
+	idleFeedsTail = slotIndex;
+	++numIdleFeeds;
+}
+
+void FNotificationBackboneManager::UnlinkIdleFeedSlot(int32 slotIndex)
+{
+	FNotificationFeedSlot& slot = feedSlots[slotIndex];
+	check(slot.bIsIdle);
+
+	if (slot.idlePrev != INDEX_NONE)
+	{
+		feedSlots[slot.idlePrev].idleNext = slot.idleNext;
+	}
+	else
+	{
+		idleFeedsHead = slot.idleNext;
+	}
+
+	if (slot.idleNext != INDEX_NONE)
+	{
+		feedSlots[slot.idleNext].idlePrev = slot.idlePrev;
+	}
+	else
+	{
+		idleFeedsTail = slot.idlePrev;
+	}
+
+	slot.bIsIdle = false;
+	slot.idlePrev = INDEX_NONE;
+	slot.idleNext = INDEX_NONE;
+	--numIdleFeeds;
+}
+
+int32 FNotificationBackboneManager::ResolveFeedSlot(FNotificationFeedHandle& handle, bool bCreateWhenNotExists)
+{
+	if (IsHandleValid(handle))
+	{
+		return handle.index;
+	}
+
+	// Stale or never resolved, go by name.
+	int32 slotIndex = INDEX_NONE;
+	if (bCreateWhenNotExists)
+	{
+		slotIndex = CreateNotificationFeedWhenNotExists(handle.feed);
+	}
+	else if (const int32* existingSlotIndex = feedSlotIndices.Find(handle.feed))
+	{
+		slotIndex = *existingSlotIndex;
+	}
+
+	handle.index = slotIndex;
+	handle.generation = slotIndex != INDEX_NONE ? feedSlots[slotIndex].generation : 0;
+	return slotIndex;
+}
+
+void FNotificationBackboneManager::ClearNotificationFeeds()
+{
+	MF_LOG(Log, false, "Clearing notification listeners.");
+	// Keep the slots, only release them. Their generations must keep going up so no old handle matches again.
+	for (int32 slotIndex = 0; slotIndex < feedSlots.Num(); ++slotIndex)
+	{
+		FNotificationFeedSlot& slot = feedSlots[slotIndex];
+		if (slot.feed.IsValid())
+		{
+			RetireFeedCounters(*slot.feed);
+			slot.feed.Reset();
+			++slot.generation;
+			slot.bIsIdle = false;
+			slot.idlePrev = INDEX_NONE;
+			slot.idleNext = INDEX_NONE;
+			freeFeedSlots.Add(slotIndex);
+		}
+	}
+	feedSlotIndices.Empty();
+	idleFeedsHead = INDEX_NONE;
+	idleFeedsTail = INDEX_NONE;
+	numIdleFeeds = 0;
+	recycledFeeds.Empty();
+	scheduledFeeds.Empty();
+	nextFrameFeeds.Empty();
+	incomingNotifications.Empty();
+	patternTrie.Empty();
+	patternSubscriptions.Empty();
+}
+
+bool FNotificationBackboneManager::GetFeedStats(const FName& feed, FNotificationBackboneFeedStats& outStats) const
+{
+	const FNotificationBackboneFeedCounters* retiredCounters = retiredFeedCounters.Find(feed);
+	const FNotificationBackboneNotificationFeed* pfeed = GetNotificationFeed(feed);
+	if (!retiredCounters && !pfeed)
+	{
+		return false;
+	}
+
+	FNotificationBackboneFeedCounters counters;
+	if (retiredCounters)
+	{
+		counters.Append(*retiredCounters);
+	}
+	if (pfeed)
+	{
+		counters.Append(pfeed->GetCounters());
+	}
+
+	outStats = FNotificationBackboneFeedStats();
+	outStats.feed = feed;
+	outStats.numQueuedNotifications = pfeed ? pfeed->GetNumNotifications() : 0;
+	counters.ToStats(outStats);
+	return true;
+}
+
+void FNotificationBackboneManager::GetAllFeedStats(TArray<FNotificationBackboneFeedStats>& outStats) const
+{
+	TSet<FName> feeds;
+	for (const TPair<FName, int32>& feedSlotIndex : feedSlotIndices)
+	{
+		feeds.Add(feedSlotIndex.Key);
+	}
+	for (const TPair<FName, FNotificationBackboneFeedCounters>& retired : retiredFeedCounters)
+	{
+		feeds.Add(retired.Key);
+	}
+
+	outStats.Reset(feeds.Num());
+	for (const FName& feed : feeds)
+	{
+		const int32 index = outStats.AddDefaulted();
+		GetFeedStats(feed, outStats[index]);
+	}
+	outStats.Sort([](const FNotificationBackboneFeedStats& a, const FNotificationBackboneFeedStats& b)
+	{
+		return a.feed.Compare(b.feed) < 0;
+	});
+}
+
+void FNotificationBackboneManager::ResetFeedStats(const FName& feed)
+{
+	if (feed.IsNone())
+	{
+		retiredFeedCounters.Empty();
+		retiredFeedNames.Empty();
+		for (FNotificationFeedSlot& slot : feedSlots)
+		{
+			if (slot.feed.IsValid())
+			{
+				slot.feed->ResetCounters();
+			}
+		}
+		return;
+	}
+
+	retiredFeedCounters.Remove(feed);
+	retiredFeedNames.Remove(feed);
+	if (FNotificationBackboneNotificationFeed* pfeed = GetNotificationFeed(feed))
+	{
+		pfeed->ResetCounters();
+	}
+}
+
+FNotificationBackboneFeedSettings FNotificationBackboneManager::GetFeedSettings(const FName& feed) const
+{
+	const FNotificationBackboneFeedSettings* overrideSettings = feedSettingsOverrides.Find(feed);
+	if (overrideSettings)
+	{
+		return *overrideSettings;
+	}
+
+	const FNotificationBackboneFeedSettings* projectSettings = UNotificationBackboneSettings::Get()->FindFeedSettings(feed);
+	return projectSettings ? *projectSettings : FNotificationBackboneFeedSettings();
+}
+
+void FNotificationBackboneManager::ReloadFeedSettings()
+{
+	for (int32 slotIndex = 0; slotIndex < feedSlots.Num(); ++slotIndex)
+	{
+		TSharedPtr<FNotificationBackboneNotificationFeed> feed = feedSlots[slotIndex].feed;
+		if (feed.IsValid())
+		{
+			feed->LoadSettings();
+			RetireNotificationFeedWhenEmpty(slotIndex);
+		}
+	}
+}
+
+void FNotificationBackboneManager::OverrideFeedSettings(const FName& feed, TFunctionRef<void(FNotificationBackboneFeedSettings&)> modify)
+{
+	FNotificationBackboneFeedSettings* overrideSettings = feedSettingsOverrides.Find(feed);
+	if (!overrideSettings)
+	{
+		overrideSettings = &feedSettingsOverrides.Add(feed, GetFeedSettings(feed));
+	}
+	modify(*overrideSettings);
+
+	const int32* slotIndex = feedSlotIndices.Find(feed);
+	if (slotIndex)
+	{
+		const int32 index = *slotIndex;
+		TSharedPtr<FNotificationBackboneNotificationFeed> pfeed = feedSlots[index].feed;
+		pfeed->ApplySettings(*overrideSettings);
+		RetireNotificationFeedWhenEmpty(index);
+	}
+}
+
+void FNotificationBackboneManager::ClearFeedSettingsOverrides(const FName& feed)
+{
+	if (feed.IsNone())
+	{
+		feedSettingsOverrides.Empty();
+	}
+	else
+	{
+		feedSettingsOverrides.Remove(feed);
+	}
+	ReloadFeedSettings();
+}
+
+#pragma region Console
+namespace NotificationBackboneConsole
+{
+	static void SetFeedDelay(const TArray<FString>& args)
+	{
+		if (args.Num() < 2)
+		{
+			MF_LOG(Warning, false, "Usage: NotificationBackbone.SetFeedDelay <Feed> <Seconds>");
+			return;
+		}
+		const float dispatchDelay = FMath::Max(FCString::Atof(*args[1]), 0.f);
+		FNotificationBackboneManager::Get().OverrideFeedSettings(FName(*args[0]), [dispatchDelay](FNotificationBackboneFeedSettings& settings)
+		{
+			settings.dispatchDelay = dispatchDelay;
+		});
+	}
+
+	static void SetFeedCaching(const TArray<FString>& args)
+	{
+		if (args.Num() < 2)
+		{
+			MF_LOG(Warning, false, "Usage: NotificationBackbone.SetFeedCaching <Feed> <CacheNoListeners 0/1> [ClearNoListeners 0/1]");
+			return;
+		}
+		const bool bCache = FCString::ToBool(*args[1]);
+		const bool bHasClear = args.Num() > 2;
+		const bool bClear = bHasClear && FCString::ToBool(*args[2]);
+		FNotificationBackboneManager::Get().OverrideFeedSettings(FName(*args[0]), [bCache, bHasClear, bClear](FNotificationBackboneFeedSettings& settings)
+		{
+			settings.bCacheNotificationsNoListeners = bCache;
+			if (bHasClear)
+			{
+				settings.bClearNotificationsNoListeners = bClear;
+			}
+		});
+	}
+
+	static void SetFeedBudget(const TArray<FString>& args)
+	{
+		if (args.Num() < 2)
+		{
+			MF_LOG(Warning, false, "Usage: NotificationBackbone.SetFeedBudget <Feed> <MaxDispatchesPerFrame> [MaxMicrosecondsPerFrame] [BatchSize]");
+			return;
+		}
+		const int32 maxDispatches = FMath::Max(FCString::Atoi(*args[1]), 0);
+		const float maxMicroseconds = args.Num() > 2 ? FMath::Max(FCString::Atof(*args[2]), 0.f) : -1.f;
+		const int32 batchSize = args.Num() > 3 ? FMath::Max(FCString::Atoi(*args[3]), 1) : 0;
+		FNotificationBackboneManager::Get().OverrideFeedSettings(FName(*args[0]), [maxDispatches, maxMicroseconds, batchSize](FNotificationBackboneFeedSettings& settings)
+		{
+			settings.maxDispatchesPerFrame = maxDispatches;
+			if (maxMicroseconds >= 0.f)
+			{
+				settings.maxDispatchMicrosecondsPerFrame = maxMicroseconds;
+			}
+			if (batchSize > 0)
+			{
+				settings.dispatchBatchSize = batchSize;
+			}
+		});
+	}
+
+	static void ResetFeedOverrides(const TArray<FString>& args)
+	{
+		FNotificationBackboneManager::Get().ClearFeedSettingsOverrides(args.Num() > 0 ? FName(*args[0]) : NAME_None);
+	}
+
+	static void DumpStats(const TArray<FString>& args)
+	{
+		TArray<FNotificationBackboneFeedStats> allStats;
+		FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+		if (args.Num() > 0)
+		{
+			FNotificationBackboneFeedStats stats;
+			if (!manager.GetFeedStats(FName(*args[0]), stats))
+			{
+				MF_LOG(Display, false, "No stats for feed %s", *args[0]);
+				return;
+			}
+			allStats.Add(stats);
+		}
+		else
+		{
+			manager.GetAllFeedStats(allStats);
+		}
+
+		MF_LOG(Display, false, "Stats of %d notification feeds. Latencies in ms.", allStats.Num());
+		for (const FNotificationBackboneFeedStats& stats : allStats)
+		{
+			MF_LOG(Display, false, "%s: Enqueued %d, Coalesced %d, Dispatched %d, DroppedNoListeners %d, DroppedOverflow %d, Cleared %d, Queued %d, MaxQueued %d",
+				*stats.feed.ToString(), stats.numEnqueued, stats.numCoalesced, stats.numDispatched, stats.numDroppedNoListeners, stats.numDroppedOverflow,
+				stats.numCleared, stats.numQueuedNotifications, stats.maxQueuedNotifications);
+			MF_LOG(Display, false, "%s: Latency avg %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f. Listeners %.3f ms, slowest %s %.3f ms",
+				*stats.feed.ToString(), stats.averageLatencyMilliseconds, stats.latencyP50Milliseconds, stats.latencyP90Milliseconds, stats.latencyP99Milliseconds,
+				stats.maxLatencyMilliseconds, stats.listenerMilliseconds, *stats.slowestListener.ToString(), stats.slowestListenerMilliseconds);
+		}
+	}
+
+	static void ResetStats(const TArray<FString>& args)
+	{
+		FNotificationBackboneManager::Get().ResetFeedStats(args.Num() > 0 ? FName(*args[0]) : NAME_None);
+	}
+
+	static void StartCapture(const TArray<FString>& args)
+	{
+		const FString path = args.Num() > 0 ? args[0]
+			: FPaths::Combine(FPaths::ProfilingDir(), TEXT("NotificationBackbone"), FString::Printf(TEXT("Capture-%s.nbcap"), *FDateTime::Now().ToString()));
+		FNotificationBackboneManager::Get().StartCapture(path);
+	}
+
+	static void StopCapture(const TArray<FString>& args)
+	{
+		FNotificationBackboneManager::Get().StopCapture();
+	}
+
+	static FAutoConsoleCommand SetFeedDelayCommand(
+		TEXT("NotificationBackbone.SetFeedDelay"),
+		TEXT("Overrides the dispatch delay of a feed. <Feed> <Seconds>"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SetFeedDelay));
+
+	static FAutoConsoleCommand SetFeedCachingCommand(
+		TEXT("NotificationBackbone.SetFeedCaching"),
+		TEXT("Overrides whether a feed caches notifications without listeners. <Feed> <CacheNoListeners 0/1> [ClearNoListeners 0/1]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SetFeedCaching));
+
+	static FAutoConsoleCommand SetFeedBudgetCommand(
+		TEXT("NotificationBackbone.SetFeedBudget"),
+		TEXT("Overrides the per frame budget of a feed, 0 for no limit. <Feed> <MaxDispatchesPerFrame> [MaxMicrosecondsPerFrame] [BatchSize]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SetFeedBudget));
+
+	static FAutoConsoleCommand ResetFeedOverridesCommand(
+		TEXT("NotificationBackbone.ResetFeedOverrides"),
+		TEXT("Drops the console overrides of a feed, of all feeds without argument. [Feed]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&ResetFeedOverrides));
+
+	static FAutoConsoleCommand DumpStatsCommand(
+		TEXT("NotificationBackbone.DumpStats"),
+		TEXT("Logs the stats of a feed, of all feeds without argument. [Feed]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpStats));
+
+	static FAutoConsoleCommand ResetStatsCommand(
+		TEXT("NotificationBackbone.ResetStats"),
+		TEXT("Starts the stats of a feed over, of all feeds without argument. [Feed]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&ResetStats));
+
+	static FAutoConsoleCommand StartCaptureCommand(
+		TEXT("NotificationBackbone.StartCapture"),
+		TEXT("Records every dispatched notification, for NotificationBackbone.Replay. Saved/Profiling/NotificationBackbone without argument. [File]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StartCapture));
+
+	static FAutoConsoleCommand StopCaptureCommand(
+		TEXT("NotificationBackbone.StopCapture"),
+		TEXT("Stops recording and closes the capture."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StopCapture));
+}
+#pragma endregion Console
+
+UTexture2D* FNotificationBackboneManager::GetPlaceholderIcon()
+{
+	if (!bPlaceholderIconLoaded)
+	{
+		// Small and only once, a synchronous load is fine.
+		bPlaceholderIconLoaded = true;
+		placeholderIcon = UNotificationBackboneSettings::Get()->placeholderIcon.LoadSynchronous();
+	}
+	return placeholderIcon;
+}
+
+void FNotificationBackboneManager::RetainAsyncListenerIcon(UTexture2D* icon)
+{
+	check(IsInGameThread());
+	asyncListenerIcons.Add(icon);
+}
+
+void FNotificationBackboneManager::ReleaseAsyncListenerIcon(UTexture2D* icon)
+{
+	check(IsInGameThread());
+	if (asyncListenerIcons.RemoveSingleSwap(icon) == 0)
+	{
+		// Got marked pending kill meanwhile, the collector nulled our entry.
+		asyncListenerIcons.RemoveSingleSwap(nullptr);
+	}
+}
+
+void FNotificationBackboneManager::AddReferencedObjects(FReferenceCollector& collector)
+{
+	if (placeholderIcon)
+	{
+		collector.AddReferencedObject(placeholderIcon);
+	}
+
+	collector.AddReferencedObjects(asyncListenerIcons);
+
+	for (FNotificationFeedSlot& slot : feedSlots)
+	{
+		if (slot.feed.IsValid())
+		{
+			slot.feed->AddReferencedObjects(collector);
+		}
+	}
+}
+
+UFunction* FNotificationBackboneManager::FindListenerFunction(UClass* listenerClass)
+{
+	UFunction** cached = listenerFunctions.Find(listenerClass);
+	if (cached)
+	{
+		return *cached;
+	}
+
+	static const FName onNotificationName(TEXT("OnNotification"));
+	UFunction* function = listenerClass->FindFunctionByName(onNotificationName);
+	listenerFunctions.Add(listenerClass, function);
+	return function;
+}
+
+void FNotificationBackboneManager::OnPostGarbageCollect()
+{
+	// Classes might have been collected (e.g. recompiled Blueprints).
+	listenerFunctions.Reset();
+
+	for (auto subscription = patternSubscriptions.CreateIterator(); subscription; ++subscription)
+	{
+		if (subscription->IsStale())
+		{
+			for (FPatternTrieNode& node : patternTrie)
+			{
+				node.subscriptions.RemoveSingleSwap(subscription.GetIndex(), false);
+				node.deepSubscriptions.RemoveSingleSwap(subscription.GetIndex(), false);
+			}
+			subscription.RemoveCurrent();
+		}
+	}
+
+	for (int32 slotIndex = 0; slotIndex < feedSlots.Num(); ++slotIndex)
+	{
+		FNotificationFeedSlot& slot = feedSlots[slotIndex];
+		if (slot.feed.IsValid() && !slot.feed->IsDispatching())
+		{
+			slot.feed->PurgeStaleListeners();
+			RetireNotificationFeedWhenEmpty(slotIndex);
+		}
+	}
+}
+
+bool FNotificationBackboneManager::Tick(float deltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_Tick);
+
+	schedulerSeconds += deltaSeconds;
+
+	// New frame, new budget.
+	++frameNumber;
+	frameDispatchCount = 0;
+	frameDispatchCycles = 0;
+
+	DispatchScheduledFeeds();
+	FlushIncomingNotifications();
+	EvictIdleNotificationFeeds();
+	return true;
 }
@@ -1,164 +1,1032 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "NotificationBackboneNotificationFeed.h"
+#include "NotificationBackboneManager.h"
+#include "UObject/UnrealType.h"
 
-FNotificationBackboneNotificationFeed::FNotificationBackboneNotificationFeed(const FName& in_feedName) : feedName(in_feedName)
+// The parameters of OnNotification, laid out by the properties of the interface function like the ones UHT generates.
+// Blueprint implementers have the same layout. They get the notification as const reference and cannot change it,
+// so all of them share one copy.
+struct FNotificationBackboneNotificationFeed::FObjectListenerParams
 {
-	// look for settings that belong to this feed.
-	const FNotificationBackboneFeedSettings* p_settings = UNotificationBackboneSettings::Get()->feedSettings.FindByPredicate(
-		[in_feedName](const FNotificationBackboneFeedSettings& in_settings) -> bool
+	explicit FObjectListenerParams(const FNotificationBackboneNotification& in_notification) : notification(in_notification)
 	{
-		return in_settings.feed == in_feedName;
-	});
+	}
 
-	if (p_settings)
+	~FObjectListenerParams()
 	{
-		settings = *p_settings;
+		if (memory)
+		{
+			for (TFieldIterator<UProperty> property(function); property && property->HasAnyPropertyFlags(CPF_Parm); ++property)
+			{
+				property->DestroyValue_InContainer(memory);
+			}
+			FMemory::Free(memory);
+		}
+	}
+
+	// Builds the parameters the first time a Blueprint listener needs them.
+	void* Get()
+	{
+		if (!memory)
+		{
+			function = FNotificationBackboneManager::Get().FindListenerFunction(UNotificationBackboneListener::StaticClass());
+			check(function);
+			memory = (uint8*)FMemory::Malloc(FMath::Max<int32>(function->ParmsSize, 1), function->GetMinAlignment());
+			FMemory::Memzero(memory, function->ParmsSize);
+			for (TFieldIterator<UProperty> property(function); property && property->HasAnyPropertyFlags(CPF_Parm); ++property)
+			{
+				property->InitializeValue_InContainer(memory);
+				UStructProperty* structProperty = Cast<UStructProperty>(*property);
+				if (structProperty && structProperty->Struct == FNotificationBackboneNotification::StaticStruct())
+				{
+					structProperty->CopyCompleteValue(structProperty->ContainerPtrToValuePtr<void>(memory), &notification);
+				}
+			}
+		}
+		return memory;
 	}
 
-	// Create delegate for ticker
-	tickerDelegate = FTickerDelegate::CreateRaw(this, &FNotificationBackboneNotificationFeed::DispatchNotificationFromQueue);
+	const FNotificationBackboneNotification& notification;
+
+private:
+	UFunction* function = nullptr;
+	uint8* memory = nullptr;
+};
+
+FNotificationBackboneNotificationFeed::FNotificationBackboneNotificationFeed(const FName& in_feedName) : feedName(in_feedName)
+{
+	LoadSettings();
 
 	MF_LOG(Log, false, "New notification feed created. FeedName: %s", *feedName.ToString());
 }
 
+void FNotificationBackboneNotificationFeed::LoadSettings()
+{
+	ApplySettings(FNotificationBackboneManager::Get().GetFeedSettings(feedName));
+}
+
+void FNotificationBackboneNotificationFeed::ApplySettings(const FNotificationBackboneFeedSettings& newSettings)
+{
+	settings = newSettings;
+
+	if (settings.maxQueuedNotifications > 0)
+	{
+		// Most notifications come in with normal priority. The other lanes grow up to the limit when used.
+		// A lower limit only applies to notifications that come in from now on.
+		notificationLanes[(int32)ENotificationBackbonePriority::Normal].Reserve(settings.maxQueuedNotifications);
+	}
+
+	if (!GetDoesHaveListeners() && settings.bClearNotificationsNoListeners)
+	{
+		ClearNotifications();
+	}
+
+	// A scheduled feed picks up the new delay the next time it fires.
+	StartDispatching();
+}
+
+void FNotificationBackboneNotificationFeed::ResetForFeed(const FName& in_feedName)
+{
+	check(!GetDoesHaveListeners() && !GetDoesHaveNotifications());
+
+	bIsScheduled = false;
+	bCascadePending = false;
+	bBlockDispatch = false;
+	frameDispatchCount = 0;
+	frameDispatchCycles = 0;
+
+	feedName = in_feedName;
+	ResetCounters();
+	mergeFunction.Unbind();
+	LoadSettings();
+
+	MF_LOG(Verbose, false, "Recycled notification feed. FeedName: %s", *feedName.ToString());
+}
+
 FNotificationBackboneNotificationFeed::~FNotificationBackboneNotificationFeed()
 {
 	MF_LOG(Log, false, "Notification feed got destroyed: FeedName: %s", *feedName.ToString());
 
-	// Remove our ticker delegate from the ticker. Else bad things might happen if the ticker tries to callback to a destroyed object.
-	FTicker::GetCoreTicker().RemoveTicker(tickerDelegateHandle);
-
-	if (!notificationQueue.IsEmpty())
+	if (GetDoesHaveNotifications())
 	{
-		MF_LOG(Warning, true, "Notification feed got destroyed but there were notifications left: FeedName: %s, NumNotifications: %d", *feedName.ToString(), notificationQueue.Num());
+		MF_LOG(Warning, true, "Notification feed got destroyed but there were notifications left: FeedName: %s, NumNotifications: %d", *feedName.ToString(), GetNumNotifications());
 	}
 }
 
-void FNotificationBackboneNotificationFeed::AddListener(TSharedRef<INotificationBackboneListenerRaw> listener)
+void FNotificationBackboneNotificationFeed::AddListener(TSharedRef<INotificationBackboneListenerRaw> listener, const FNotificationBackboneListenerOptions& options)
 {
-	listenersRaw.Add(TWeakPtr<INotificationBackboneListenerRaw>(listener));
-	StartDispatchTicker();
+	FListenerEntry entry;
+	entry.raw = listener;
+	entry.key = &listener.Get();
+	entry.SetOptions(options);
+	AddListenerEntry(entry);
 }
 
 void FNotificationBackboneNotificationFeed::RemoveListener(TSharedRef<INotificationBackboneListenerRaw> listener)
 {
-	listenersRaw.Remove(listener);
+	RemoveListenerEntry(&listener.Get());
+}
+
+void FNotificationBackboneNotificationFeed::AddListenerObject(TScriptInterface<INotificationBackboneListener> listener, const FNotificationBackboneListenerOptions& options)
+{
+	if (!listener.GetObject())
+	{
+		return;
+	}
+
+	FListenerEntry entry;
+	entry.object = listener.GetObject();
+	entry.key = listener.GetObject();
+	entry.bIsObject = true;
+	entry.SetOptions(options);
+
+	// Decide once whether C++ implements the listener, it does not have to go through ProcessEvent then.
+	UFunction* function = FNotificationBackboneManager::Get().FindListenerFunction(listener.GetObject()->GetClass());
+	INotificationBackboneListener* nativeObject = Cast<INotificationBackboneListener>(listener.GetObject());
+	if (function && function->HasAnyFunctionFlags(FUNC_Native) && nativeObject)
+	{
+		entry.nativeObject = nativeObject;
+	}
+	AddListenerEntry(entry);
+}
+
+void FNotificationBackboneNotificationFeed::RemoveListenerObject(TScriptInterface<INotificationBackboneListener> listener)
+{
+	RemoveListenerEntry(listener.GetObject());
+}
+
+FNotificationBackboneNotificationFeed::FListenerEntry* FNotificationBackboneNotificationFeed::FindListenerEntry(const void* key)
+{
+	const int32* index = listenerIndices.Find(key);
+	if (index)
+	{
+		return &listeners[*index];
+	}
+
+	const FName* filterKey = keyedListenerKeys.Find(key);
+	if (filterKey)
+	{
+		// Few listeners per key.
+		return keyedListeners.FindChecked(*filterKey).FindByPredicate([key](const FListenerEntry& listener)
+		{
+			return listener.key == key;
+		});
+	}
+	return nullptr;
+}
+
+void FNotificationBackboneNotificationFeed::InsertListenerEntry(const FListenerEntry& entry)
+{
+	if (entry.filterKey.IsNone())
+	{
+		listenerIndices.Add(entry.key, listeners.Add(entry));
+	}
+	else
+	{
+		keyedListeners.FindOrAdd(entry.filterKey).Add(entry);
+		keyedListenerKeys.Add(entry.key, entry.filterKey);
+		++numKeyedListeners;
+	}
+	numObjectListeners += entry.bIsObject ? 1 : 0;
+}
+
+void FNotificationBackboneNotificationFeed::AddListenerEntry(const FListenerEntry& entry)
+{
+	// Subscribing again replaces the entry. The options may have changed, or the listener is a new one at the address of a dead one.
+	FListenerEntry* pending = pendingListeners.FindByPredicate([&entry](const FListenerEntry& pendingListener)
+	{
+		return pendingListener.key == entry.key;
+	});
+	if (pending)
+	{
+		*pending = entry;
+		return;
+	}
+
+	FListenerEntry* existing = FindListenerEntry(entry.key);
+	if (existing && existing->filterKey == entry.filterKey)
+	{
+		// Stays in its place, also while we dispatch.
+		if (existing->bRemoved)
+		{
+			--numRemovedListeners;
+		}
+		numObjectListeners += (entry.bIsObject ? 1 : 0) - (existing->bIsObject ? 1 : 0);
+		*existing = entry;
+	}
+	else if (IsDispatching())
+	{
+		if (existing)
+		{
+			// Moves to the bucket of its new filter key once we are done.
+			MarkListenerRemoved(*existing);
+		}
+		pendingListeners.Add(entry);
+		// The dispatch going on picks up the rest of the queue.
+		return;
+	}
+	else
+	{
+		if (existing)
+		{
+			EraseListenerEntry(entry.key);
+		}
+		InsertListenerEntry(entry);
+	}
+
+	StartDispatching();
+}
+
+void FNotificationBackboneNotificationFeed::RemoveListenerEntry(const void* key)
+{
+	pendingListeners.RemoveAll([key](const FListenerEntry& pending)
+	{
+		return pending.key == key;
+	});
+	EraseListenerEntry(key);
+
 	if (!GetDoesHaveListeners() && settings.bClearNotificationsNoListeners)
 	{
 		ClearNotifications();
 	}
 }
 
-void FNotificationBackboneNotificationFeed::AddListenerObject(TScriptInterface<INotificationBackboneListener> listener)
+void FNotificationBackboneNotificationFeed::EraseListenerEntry(const void* key)
 {
-	listenersObject.Add(listener);
-	StartDispatchTicker();
+	const int32* index = listenerIndices.Find(key);
+	const FName* filterKey = index ? nullptr : keyedListenerKeys.Find(key);
+	if ((index || filterKey) && IsDispatching())
+	{
+		MarkListenerRemoved(*FindListenerEntry(key));
+	}
+	else if (index)
+	{
+		// Order does not matter, swap the last one in.
+		const int32 removedIndex = *index;
+		numObjectListeners -= listeners[removedIndex].bIsObject ? 1 : 0;
+		listenerIndices.Remove(key);
+		listeners.RemoveAtSwap(removedIndex, 1, false);
+		if (listeners.IsValidIndex(removedIndex))
+		{
+			listenerIndices.Add(listeners[removedIndex].key, removedIndex);
+		}
+	}
+	else if (filterKey)
+	{
+		const FName bucketKey = *filterKey;
+		TArray<FListenerEntry>& bucket = keyedListeners.FindChecked(bucketKey);
+		const int32 removedIndex = bucket.IndexOfByPredicate([key](const FListenerEntry& listener)
+		{
+			return listener.key == key;
+		});
+		numObjectListeners -= bucket[removedIndex].bIsObject ? 1 : 0;
+		bucket.RemoveAtSwap(removedIndex, 1, false);
+		if (bucket.Num() == 0)
+		{
+			keyedListeners.Remove(bucketKey);
+		}
+		keyedListenerKeys.Remove(key);
+		--numKeyedListeners;
+	}
 }
 
-void FNotificationBackboneNotificationFeed::RemoveListenerObject(TScriptInterface<INotificationBackboneListener> listener)
+void FNotificationBackboneNotificationFeed::MarkListenerRemoved(FListenerEntry& entry)
 {
-	listenersObject.Remove(listener);
-	if (listenersObject.Num() == 0 && settings.bClearNotificationsNoListeners)
+	if (!entry.bRemoved)
 	{
-		ClearNotifications();
+		entry.bRemoved = true;
+		++numRemovedListeners;
 	}
 }
 
-bool FNotificationBackboneNotificationFeed::DispatchNotificationFromQueue(float deltaSeconds /*= 0.f*/)
+void FNotificationBackboneNotificationFeed::ApplyPendingListenerChanges()
 {
-	if (!bBlockDispatch && GetDoesHaveListeners() && !notificationQueue.IsEmpty())
+	check(!IsDispatching());
+
+	if (numRemovedListeners > 0)
 	{
-		FNotificationBackboneNotification notification;
-		if (notificationQueue.Dequeue(notification))
+		auto isRemoved = [](const FListenerEntry& listener)
 		{
-			notification.feedDispatchDelay = settings.dispatchDelay;
+			return listener.bRemoved;
+		};
 
-			// object listener
-			for (auto objectIter = listenersObject.CreateIterator(); objectIter; ++objectIter)
+		listeners.RemoveAll(isRemoved);
+		listenerIndices.Reset();
+		for (int32 index = 0; index < listeners.Num(); ++index)
+		{
+			listenerIndices.Add(listeners[index].key, index);
+		}
+
+		for (auto bucket = keyedListeners.CreateIterator(); bucket; ++bucket)
+		{
+			for (const FListenerEntry& listener : bucket.Value())
 			{
-				if (objectIter->GetObject() && objectIter->GetObject()->IsValidLowLevelFast())
+				if (listener.bRemoved)
 				{
-					INotificationBackboneListener::Execute_OnNotification(objectIter->GetObject(), notification);
-				}
-				else
-				{
-					objectIter.RemoveCurrent();
+					keyedListenerKeys.Remove(listener.key);
 				}
 			}
+			bucket.Value().RemoveAll(isRemoved);
+			if (bucket.Value().Num() == 0)
+			{
+				bucket.RemoveCurrent();
+			}
+		}
+		numRemovedListeners = 0;
+
+		// Recount what is left.
+		numKeyedListeners = keyedListenerKeys.Num();
+		numObjectListeners = 0;
+		ForEachListener([this](FListenerEntry& listener)
+		{
+			numObjectListeners += listener.bIsObject ? 1 : 0;
+		});
+	}
+
+	for (const FListenerEntry& pending : pendingListeners)
+	{
+		InsertListenerEntry(pending);
+	}
+	pendingListeners.Reset();
+}
+
+void FNotificationBackboneNotificationFeed::PurgeStaleListeners()
+{
+	check(!IsDispatching());
+
+	if (numObjectListeners == 0)
+	{
+		// Raw listeners get removed during dispatch, the garbage collector does not touch them.
+		return;
+	}
+
+	ForEachListener([this](FListenerEntry& listener)
+	{
+		if (listener.IsStale())
+		{
+			MarkListenerRemoved(listener);
+		}
+	});
+	pendingListeners.RemoveAll([](const FListenerEntry& pending)
+	{
+		return pending.IsStale();
+	});
+	ApplyPendingListenerChanges();
+
+	if (!GetDoesHaveListeners() && settings.bClearNotificationsNoListeners)
+	{
+		ClearNotifications();
+	}
+}
+
+bool FNotificationBackboneNotificationFeed::DispatchNotificationFromQueue()
+{
+	if (!CanDispatch())
+	{
+		return false;
+	}
 
-			// raw listener
-			for (auto rawIter = listenersRaw.CreateIterator(); rawIter; ++rawIter)
+	SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_DispatchNotificationFromQueue);
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FQueuedNotification queued;
+	if (!DequeueNotification(queued))
+	{
+		check(0); // Should never reach this
+		return false;
+	}
+	const FNotificationBackboneNotificationRef notification = queued.notification.ToSharedRef();
+	NOTIFICATIONBACKBONE_TRACE(Dequeue, queued.id, feedName, NAME_None, numQueuedNotifications);
+
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	++counters.numDispatched;
+	counters.RecordLatency(startCycles - queued.enqueueCycles);
+	INC_DWORD_STAT(STAT_NotificationBackbone_NumDispatched);
+
+	FNotificationBackboneDispatchContext context;
+	context.feed = feedName;
+	context.feedDispatchDelay = settings.dispatchDelay;
+	context.numQueuedNotifications = numQueuedNotifications;
+
+	context.icon = notification->GetIcon();
+	if (!context.icon && !notification->softIcon.IsNull())
+	{
+		context.icon = manager.GetPlaceholderIcon();
+	}
+
+	// UObject listeners only get the notification. They read the delay, the texts and the icon from it. The manager stamps the delay
+	// when it builds the notification for us, notifications built by the producer, with deferred texts or a soft icon need a stamped copy.
+	TOptional<FNotificationBackboneNotification> stampedNotification;
+	if (numObjectListeners > 0 && (notification->feedDispatchDelay != settings.dispatchDelay || notification->HasDeferredText() || notification->HasUnresolvedIcon()))
+	{
+		stampedNotification.Emplace(*notification);
+		stampedNotification->feedDispatchDelay = settings.dispatchDelay;
+		stampedNotification->ResolveDeferredText();
+		stampedNotification->icon = context.icon;
+	}
+	FObjectListenerParams objectParams(stampedNotification.IsSet() ? stampedNotification.GetValue() : *notification);
+
+	// Listeners (un)subscribing from within OnNotification only get noted down until we are done.
+	// Neither the arrays nor the buckets change meanwhile. Feeds they dispatch into go once the batch is done, see DeferFeedDispatch.
+	++dispatchDepth;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_NotifyListeners);
+
+		const int32 numListeners = listeners.Num();
+		for (int32 index = 0; index < numListeners; ++index)
+		{
+			NotifyListener(listeners[index], notification, objectParams, context, queued.id);
+		}
+
+		if (notification->routingKey.IsNone())
+		{
+			// Goes to everybody.
+			for (TPair<FName, TArray<FListenerEntry>>& bucket : keyedListeners)
 			{
-				if (rawIter->IsValid())
-				{
-					TSharedPtr<INotificationBackboneListenerRaw> pinnedRaw = rawIter->Pin();
-					if (pinnedRaw.IsValid())
-					{
-						pinnedRaw->OnNotification(notification);
-					}
-				}
-				else
+				for (FListenerEntry& listener : bucket.Value)
 				{
-					rawIter.RemoveCurrent();
+					NotifyListener(listener, notification, objectParams, context, queued.id);
 				}
 			}
 		}
+		else if (TArray<FListenerEntry>* bucket = keyedListeners.Find(notification->routingKey))
+		{
+			// Only the listeners with that key, the others never hear of it.
+			for (FListenerEntry& listener : *bucket)
+			{
+				NotifyListener(listener, notification, objectParams, context, queued.id);
+			}
+		}
+	}
+	FinishAsyncListeners(context.icon);
+	--dispatchDepth;
+
+	if (!IsDispatching())
+	{
+		ApplyPendingListenerChanges();
+	}
+
+	// Listeners that want to keep the icon must hold on to it themselves.
+	ReleaseIcon(*notification);
+
+	const uint64 dispatchCycles = FPlatformTime::Cycles64() - startCycles;
+	++frameDispatchCount;
+	frameDispatchCycles += dispatchCycles;
+	manager.ConsumeDispatchBudget(dispatchCycles);
+	return true;
+}
+
+void FNotificationBackboneNotificationFeed::NotifyListener(FListenerEntry& listener, const FNotificationBackboneNotificationRef& notification, FObjectListenerParams& objectParams, const FNotificationBackboneDispatchContext& context, uint64 notificationId)
+{
+	if (listener.bRemoved || !listener.PassesFilter(*notification))
+	{
+		return;
+	}
+
+	if (listener.bIsObject)
+	{
+		// object listener
+		if (UObject* listenerObject = listener.object.Get())
+		{
+			NOTIFICATIONBACKBONE_TRACE(ListenerBegin, notificationId, feedName, listenerObject->GetFName());
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			NotifyObjectListener(listener, listenerObject, objectParams);
+			if (counters.RecordListenerCall(FPlatformTime::Cycles64() - startCycles))
+			{
+				counters.slowestListener = listenerObject->GetFName();
+			}
+			NOTIFICATIONBACKBONE_TRACE(ListenerEnd, notificationId, feedName, listenerObject->GetFName());
+		}
+		else
+		{
+			MarkListenerRemoved(listener);
+		}
+	}
+	else
+	{
+		// raw listener
+		TSharedPtr<INotificationBackboneListenerRaw> pinnedRaw = listener.raw.Pin();
+		if (pinnedRaw.IsValid() && listener.bAsync)
+		{
+			NotifyListenerAsync(pinnedRaw, notification, context, notificationId);
+		}
+		else if (pinnedRaw.IsValid())
+		{
+			NOTIFICATIONBACKBONE_TRACE(ListenerBegin, notificationId, feedName, pinnedRaw->GetNotificationBackboneListenerName());
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			pinnedRaw->OnNotificationWithContext(*notification, context);
+			if (counters.RecordListenerCall(FPlatformTime::Cycles64() - startCycles))
+			{
+				counters.slowestListener = pinnedRaw->GetNotificationBackboneListenerName();
+			}
+			NOTIFICATIONBACKBONE_TRACE(ListenerEnd, notificationId, feedName, pinnedRaw->GetNotificationBackboneListenerName());
+		}
 		else
 		{
-			check(0); // Should never reach this
+			MarkListenerRemoved(listener);
 		}
+	}
+}
+
+void FNotificationBackboneNotificationFeed::NotifyListenerAsync(const TSharedPtr<INotificationBackboneListenerRaw>& listener, const FNotificationBackboneNotificationRef& notification, const FNotificationBackboneDispatchContext& context, uint64 notificationId)
+{
+	if (asyncListenerEvents.Num() == 0 && notification->json.IsValid())
+	{
+		// Serialized here, so workers asking for the string only copy it and never touch the shared object.
+		notification->json->GetString();
+	}
+
+	// The shared pointer of the listener is not thread safe, only the game thread may copy or release it.
+	INotificationBackboneListenerRaw* listenerRaw = listener.Get();
+	asyncListenerRefs.Add(listener);
+
+	// After the call of the notification before, so the listener gets them in order.
+	FGraphEventRef& tail = asyncListenerTails.FindOrAdd(listenerRaw);
+	FGraphEventArray prerequisites;
+	if (tail.IsValid() && !tail->IsComplete())
+	{
+		prerequisites.Add(tail);
+	}
+
+	const FName taskFeedName = feedName;
+	tail = FFunctionGraphTask::CreateAndDispatchWhenReady([listenerRaw, notification, context, notificationId, taskFeedName]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NotificationBackbone_AsyncListener);
+		NOTIFICATIONBACKBONE_TRACE(ListenerBegin, notificationId, taskFeedName, listenerRaw->GetNotificationBackboneListenerName());
+		listenerRaw->OnNotificationWithContext(*notification, context);
+		NOTIFICATIONBACKBONE_TRACE(ListenerEnd, notificationId, taskFeedName, listenerRaw->GetNotificationBackboneListenerName());
+	}, TStatId(), &prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+	asyncListenerEvents.Add(tail);
+}
+
+void FNotificationBackboneNotificationFeed::FinishAsyncListeners(UTexture2D* icon)
+{
+	if (asyncListenerEvents.Num() == 0)
+	{
+		return;
+	}
+
+	// The calls read the icon, the manager keeps it from getting collected until they are done.
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	if (icon)
+	{
+		manager.RetainAsyncListenerIcon(icon);
+	}
+
+	// Runs on the game thread once all calls are done and releases the listeners and the icon there.
+	FGraphEventRef completion = FFunctionGraphTask::CreateAndDispatchWhenReady([listenerRefs = MoveTemp(asyncListenerRefs), icon]()
+	{
+		if (icon)
+		{
+			FNotificationBackboneManager::Get().ReleaseAsyncListenerIcon(icon);
+		}
+	}, TStatId(), &asyncListenerEvents, ENamedThreads::GameThread);
+	asyncListenerRefs.Reset();
+	asyncListenerEvents.Reset();
+
+	for (auto it = asyncListenerTails.CreateIterator(); it; ++it)
+	{
+		if (it.Value()->IsComplete())
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	asyncCompletions.RemoveAll([](const FGraphEventRef& event)
+	{
+		return event->IsComplete();
+	});
+	asyncCompletions.Add(completion);
+}
+
+FGraphEventRef FNotificationBackboneNotificationFeed::GetAsyncListenerCompletion()
+{
+	check(IsInGameThread());
+
+	asyncCompletions.RemoveAll([](const FGraphEventRef& event)
+	{
+		return event->IsComplete();
+	});
+	if (asyncCompletions.Num() == 0)
+	{
+		return nullptr;
+	}
+	if (asyncCompletions.Num() == 1)
+	{
+		return asyncCompletions[0];
+	}
+	return FFunctionGraphTask::CreateAndDispatchWhenReady([]()
+	{
+	}, TStatId(), &asyncCompletions, ENamedThreads::AnyThread);
+}
+
+void FNotificationBackboneNotificationFeed::NotifyObjectListener(const FListenerEntry& listener, UObject* listenerObject, FObjectListenerParams& objectParams)
+{
+	if (listener.nativeObject)
+	{
+		listener.nativeObject->OnNotification_Implementation(objectParams.notification);
+		return;
+	}
 
+	// Looked up per call, the functions of Blueprint classes can go away with a garbage collection. The manager caches them until then.
+	UFunction* function = FNotificationBackboneManager::Get().FindListenerFunction(listenerObject->GetClass());
+	if (function)
+	{
+		listenerObject->ProcessEvent(function, objectParams.Get());
+	}
+	else
+	{
+		INotificationBackboneListener::Execute_OnNotification(listenerObject, objectParams.notification);
+	}
+}
+
+int32 FNotificationBackboneNotificationFeed::DispatchNotificationBatch(int32 maxCount)
+{
+	int32 numDispatched = 0;
+	while (numDispatched < maxCount && HasFrameBudgetLeft() && DispatchNotificationFromQueue())
+	{
+		++numDispatched;
+	}
+	return numDispatched;
+}
+
+bool FNotificationBackboneNotificationFeed::HasFrameBudgetLeft()
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	if (budgetFrame != manager.GetFrameNumber())
+	{
+		budgetFrame = manager.GetFrameNumber();
+		frameDispatchCount = 0;
+		frameDispatchCycles = 0;
+	}
+
+	if (settings.maxDispatchesPerFrame > 0 && frameDispatchCount >= settings.maxDispatchesPerFrame)
+	{
+		return false;
+	}
+
+	if (settings.maxDispatchMicrosecondsPerFrame > 0.f && frameDispatchCycles >= FNotificationBackboneManager::MicrosecondsToCycles(settings.maxDispatchMicrosecondsPerFrame))
+	{
+		return false;
+	}
+
+	return manager.HasDispatchBudgetLeft();
+}
+
+bool FNotificationBackboneNotificationFeed::OnScheduledDispatch(float& outNextDelay)
+{
+	bIsScheduled = false;
+
+	if (!IsDelayed())
+	{
+		// We ran out of budget last frame. Goes on like any other dispatch, schedules us again if needed.
+		StartDispatching();
+		return false;
+	}
+
+	if (CanDispatch())
+	{
+		bIsScheduled = true;
 		// We just dispatched. Even if there is no more notification enqueued, we must wait another delay.
 		// Otherwise we might do a dispatch where should be a delay.
+		// Nothing dispatched means we are out of budget, then we try again the next frame.
+		FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+		manager.BeginFeedDispatch(feedName);
+		outNextDelay = DispatchNotificationBatch(FMath::Max(settings.dispatchBatchSize, 1)) > 0 ? settings.dispatchDelay : 0.f;
+		// Works through the cascade of the batch when we are the outermost dispatch. We stay scheduled meanwhile.
+		manager.EndFeedDispatch();
+		return true;
 	}
-	else
+
+	// Nothing to do. The next notification that comes in gets dispatched right away.
+	return false;
+}
+
+bool FNotificationBackboneNotificationFeed::DropWithoutListeners()
+{
+	if (GetDoesHaveListeners() || settings.bCacheNotificationsNoListeners)
 	{
-		// This is the only place where the IsTickerActive state shall reach the false state.
-		bIsTickerActive = false;
+		return false;
 	}
 
-	return bIsTickerActive;
+	NOTIFICATIONBACKBONE_TRACE(Drop, FNotificationBackboneTrace::NewNotificationId(), feedName, NAME_None, (uint32)ENotificationBackboneDispatchResult::DroppedNoListeners);
+	++counters.numDroppedNoListeners;
+	return true;
 }
 
-void FNotificationBackboneNotificationFeed::EnqueueNotification(const FNotificationBackboneNotification& notification)
+ENotificationBackboneDispatchResult FNotificationBackboneNotificationFeed::EnqueueNotification(const FNotificationBackboneNotificationRef& notification)
 {
-	if (GetDoesHaveListeners())
+	if (DropWithoutListeners())
 	{
-		notificationQueue.Enqueue(notification);
+		return ENotificationBackboneDispatchResult::DroppedNoListeners;
 	}
-	else
+
+	const uint64 notificationId = FNotificationBackboneTrace::NewNotificationId();
+
+	const bool bCoalesce = settings.coalesceMode != ENotificationBackboneCoalesceMode::None && !notification->coalescingKey.IsNone();
+	if (bCoalesce)
+	{
+		const FCoalescingSlot* coalescingSlot = coalescingIndex.Find(notification->coalescingKey);
+		if (coalescingSlot)
+		{
+			// Stays in its lane, even if the incoming notification has another priority.
+			FQueuedNotification* queued = notificationLanes[coalescingSlot->lane].FindBySequence(coalescingSlot->sequence);
+			check(queued);
+			// The icon of the merged notification might be loaded already and make us dispatch, queued is gone then.
+			const uint64 queuedId = queued->id;
+			CoalesceNotification(queued->notification, notification);
+			NOTIFICATIONBACKBONE_TRACE(Coalesce, queuedId, feedName);
+			++counters.numCoalesced;
+			return ENotificationBackboneDispatchResult::Coalesced;
+		}
+	}
+
+	ENotificationBackboneDispatchResult result = ENotificationBackboneDispatchResult::Queued;
+	if (settings.maxQueuedNotifications > 0 && numQueuedNotifications >= (uint32)settings.maxQueuedNotifications)
+	{
+		++counters.numDroppedOverflow;
+		switch (settings.overflowPolicy)
+		{
+		case ENotificationBackboneOverflowPolicy::DropNewest:
+			NOTIFICATIONBACKBONE_TRACE(Drop, notificationId, feedName, NAME_None, (uint32)ENotificationBackboneDispatchResult::DroppedOverflow);
+			return ENotificationBackboneDispatchResult::DroppedOverflow;
+		case ENotificationBackboneOverflowPolicy::Reject:
+			NOTIFICATIONBACKBONE_TRACE(Drop, notificationId, feedName, NAME_None, (uint32)ENotificationBackboneDispatchResult::Rejected);
+			return ENotificationBackboneDispatchResult::Rejected;
+		case ENotificationBackboneOverflowPolicy::DropOldest:
+		default:
+			DropOldestNotification();
+			result = ENotificationBackboneDispatchResult::QueuedDroppedOldest;
+			break;
+		}
+	}
+
+	EnqueueIntoLane(notification, notificationId, bCoalesce);
+	StartDispatching();
+	return result;
+}
+
+void FNotificationBackboneNotificationFeed::EnqueueIntoLane(const FNotificationBackboneNotificationRef& notification, uint64 notificationId, bool bIndexCoalescingKey)
+{
+	const int32 lane = FMath::Clamp((int32)notification->priority, 0, NumNotificationLanes - 1);
+	TRingQueue<FQueuedNotification>& laneQueue = notificationLanes[lane];
+
+	if (bIndexCoalescingKey)
+	{
+		coalescingIndex.Add(notification->coalescingKey, FCoalescingSlot{ lane, laneQueue.GetTailSequence() });
+	}
+	laneQueue.Enqueue(FQueuedNotification{ notification, FPlatformTime::Cycles64(), notificationId });
+	NOTIFICATIONBACKBONE_TRACE(Enqueue, notificationId, feedName, NAME_None, lane);
+	nonEmptyLanes |= 1u << lane;
+	++numQueuedNotifications;
+	++counters.numEnqueued;
+	counters.RecordQueueDepth(numQueuedNotifications);
+	RetainIcon(*notification);
+}
+
+bool FNotificationBackboneNotificationFeed::DequeueNotification(FQueuedNotification& outQueued)
+{
+	const int32 lane = SelectLaneToDispatch();
+	if (lane == INDEX_NONE)
 	{
-		if (settings.bCacheNotificationsNoListeners == true)
+		return false;
+	}
+
+	TRingQueue<FQueuedNotification>& laneQueue = notificationLanes[lane];
+	const uint64 sequence = laneQueue.GetHeadSequence();
+	laneQueue.Dequeue(outQueued);
+	ForgetCoalescingKey(*outQueued.notification, lane, sequence);
+	OnLaneShrunk(lane);
+
+	// Aging: the lane we served starts over, the lanes we passed waited once more.
+	laneStarvation[lane] = 0;
+	for (int32 lowerLane = 0; lowerLane < lane; ++lowerLane)
+	{
+		if (nonEmptyLanes & (1u << lowerLane))
 		{
-			notificationQueue.Enqueue(notification);
+			++laneStarvation[lowerLane];
 		}
 	}
+	return true;
+}
+
+void FNotificationBackboneNotificationFeed::DropOldestNotification()
+{
+	if (nonEmptyLanes == 0)
+	{
+		return;
+	}
 
-	StartDispatchTicker();
+	// The lowest priority goes first.
+	const int32 lane = FMath::CountTrailingZeros(nonEmptyLanes);
+	TRingQueue<FQueuedNotification>& laneQueue = notificationLanes[lane];
+	const FQueuedNotification* oldest = laneQueue.Peek();
+	NOTIFICATIONBACKBONE_TRACE(Drop, oldest->id, feedName, NAME_None, (uint32)ENotificationBackboneDispatchResult::QueuedDroppedOldest);
+	ForgetCoalescingKey(*oldest->notification, lane, laneQueue.GetHeadSequence());
+	ReleaseIcon(*oldest->notification);
+	laneQueue.Pop();
+	OnLaneShrunk(lane);
 }
 
-void FNotificationBackboneNotificationFeed::StartDispatchTicker()
+void FNotificationBackboneNotificationFeed::OnLaneShrunk(int32 lane)
 {
-	if (GetDoesHaveListeners() && !notificationQueue.IsEmpty())
+	--numQueuedNotifications;
+	if (notificationLanes[lane].IsEmpty())
 	{
-		if (FMath::IsNearlyZero(settings.dispatchDelay))
+		nonEmptyLanes &= ~(1u << lane);
+		laneStarvation[lane] = 0;
+	}
+}
+
+int32 FNotificationBackboneNotificationFeed::SelectLaneToDispatch() const
+{
+	if (nonEmptyLanes == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 highestLane = FMath::FloorLog2(nonEmptyLanes);
+	if (settings.priorityAgingThreshold > 0)
+	{
+		// The lowest lane that waited long enough goes first.
+		for (int32 lane = 0; lane < highestLane; ++lane)
 		{
-			// Special case. We do not use the ticker, instead we dispatch everything we got.
-			while (!bBlockDispatch && !notificationQueue.IsEmpty())
+			if ((nonEmptyLanes & (1u << lane)) && laneStarvation[lane] >= settings.priorityAgingThreshold)
 			{
-				DispatchNotificationFromQueue();
+				return lane;
 			}
 		}
-		else if (!bIsTickerActive)
+	}
+	return highestLane;
+}
+
+void FNotificationBackboneNotificationFeed::ForgetCoalescingKey(const FNotificationBackboneNotification& notification, int32 lane, uint64 sequence)
+{
+	if (!notification.coalescingKey.IsNone())
+	{
+		const FCoalescingSlot* coalescingSlot = coalescingIndex.Find(notification.coalescingKey);
+		if (coalescingSlot && coalescingSlot->lane == lane && coalescingSlot->sequence == sequence)
 		{
-			// Ticker was not active, thus we now are beyond our delay.
-			// Dispatch one directly
-			DispatchNotificationFromQueue();
+			coalescingIndex.Remove(notification.coalescingKey);
+		}
+	}
+}
+
+void FNotificationBackboneNotificationFeed::CoalesceNotification(FNotificationBackboneNotificationPtr& queued, const FNotificationBackboneNotificationRef& incoming)
+{
+	FNotificationBackboneNotification merged;
+	if (settings.coalesceMode == ENotificationBackboneCoalesceMode::Merge && mergeFunction.IsBound())
+	{
+		merged = *queued;
+		mergeFunction.Execute(merged, *incoming);
+	}
+	else
+	{
+		merged = *incoming;
+	}
 
-			// To keep our delay, we must start the ticker. Even if there is nothing enqueued anymore.
-			tickerDelegateHandle = FTicker::GetCoreTicker().AddTicker(tickerDelegate, settings.dispatchDelay);
-			bIsTickerActive = true;
+	// The merge function must not move the notification to another key.
+	merged.coalescingKey = queued->coalescingKey;
+	merged.coalescedCount = queued->coalescedCount + incoming->coalescedCount;
+
+	// Retain first, the icons might be the same. The queue must be in order already, a loaded icon might make us dispatch.
+	FNotificationBackboneNotificationPtr replaced = queued;
+	queued = MakeNotificationBackboneNotification(MoveTemp(merged));
+	RetainIcon(*queued);
+	ReleaseIcon(*replaced);
+}
+
+void FNotificationBackboneNotificationFeed::RetainIcon(const FNotificationBackboneNotification& notification)
+{
+	if (!notification.HasUnresolvedIcon())
+	{
+		return;
+	}
+
+	FIconLoad& iconLoad = iconLoads.FindOrAdd(notification.softIcon.ToSoftObjectPath());
+	if (iconLoad.numNotifications++ == 0)
+	{
+		// Already loaded icons complete right away, the handle keeps them loaded.
+		FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+		const FNotificationFeedHandle handle = selfHandle;
+		iconLoad.handle = manager.GetStreamableManager().RequestAsyncLoad(notification.softIcon.ToSoftObjectPath(), FStreamableDelegate::CreateLambda([handle]()
+		{
+			// We might be gone by now.
+			FNotificationBackboneNotificationFeed* feed = FNotificationBackboneManager::Get().GetNotificationFeed(handle);
+			if (feed)
+			{
+				feed->StartDispatching();
+			}
+		}));
+	}
+}
+
+void FNotificationBackboneNotificationFeed::ReleaseIcon(const FNotificationBackboneNotification& notification)
+{
+	if (!notification.HasUnresolvedIcon())
+	{
+		return;
+	}
+
+	const FSoftObjectPath iconPath = notification.softIcon.ToSoftObjectPath();
+	FIconLoad* iconLoad = iconLoads.Find(iconPath);
+	if (iconLoad && --iconLoad->numNotifications <= 0)
+	{
+		if (iconLoad->handle.IsValid())
+		{
+			iconLoad->handle->CancelHandle();
+		}
+		iconLoads.Remove(iconPath);
+	}
+}
+
+bool FNotificationBackboneNotificationFeed::IsWaitingForIcon() const
+{
+	if (iconLoads.Num() == 0 || settings.iconLoadPolicy != ENotificationBackboneIconLoadPolicy::HoldBack)
+	{
+		return false;
+	}
+
+	const int32 lane = SelectLaneToDispatch();
+	if (lane == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FNotificationBackboneNotification& next = *notificationLanes[lane].Peek()->notification;
+	if (!next.HasUnresolvedIcon())
+	{
+		return false;
+	}
+
+	// Icons that failed to load do not hold back the feed, the notification goes out with the placeholder.
+	const FIconLoad* iconLoad = iconLoads.Find(next.softIcon.ToSoftObjectPath());
+	return iconLoad && iconLoad->handle.IsValid() && !iconLoad->handle->HasLoadCompleted();
+}
+
+void FNotificationBackboneNotificationFeed::AddReferencedObjects(FReferenceCollector& collector)
+{
+	for (int32 lane = 0; lane < NumNotificationLanes; ++lane)
+	{
+		TRingQueue<FQueuedNotification>& laneQueue = notificationLanes[lane];
+		for (uint64 sequence = laneQueue.GetHeadSequence(); sequence < laneQueue.GetTailSequence(); ++sequence)
+		{
+			// Queued notifications are shared and must not change. The collector gets a copy of the pointer.
+			UTexture2D* icon = laneQueue.FindBySequence(sequence)->notification->icon;
+			if (icon)
+			{
+				collector.AddReferencedObject(icon);
+			}
+		}
+	}
+}
+
+void FNotificationBackboneNotificationFeed::StartDispatching()
+{
+	if (bIsScheduled || bCascadePending || !CanDispatch())
+	{
+		return;
+	}
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	if (manager.IsInFeedDispatch())
+	{
+		// A listener got us here. We go once it is done, not within it.
+		manager.DeferFeedDispatch(*this);
+		return;
+	}
+
+	// The whole batch is one dispatch for the cascade. What our listeners dispatch goes once the batch is done.
+	manager.BeginFeedDispatch(feedName);
+	if (!IsDelayed())
+	{
+		// Special case. We do not wait, instead we dispatch everything our budget allows.
+		// Only what is queued now, what our listeners dispatch to us goes with the next wave of the cascade.
+		DispatchNotificationBatch(numQueuedNotifications);
+		// Pending on the cascade or already on the next frame, e.g. deferred beyond maxCascadeDepth.
+		if (CanDispatch() && !bCascadePending && !bIsScheduled)
+		{
+			// Out of budget, the rest carries over to the next frame.
+			bIsScheduled = true;
+			manager.ScheduleFeedDispatchNextFrame(selfHandle);
+		}
+	}
+	else
+	{
+		// We were not scheduled, thus we now are beyond our delay.
+		// Dispatch directly. Mark us scheduled already, so listeners that dispatch to us do not get us here twice.
+		bIsScheduled = true;
+		if (DispatchNotificationBatch(FMath::Max(settings.dispatchBatchSize, 1)) > 0)
+		{
+			// To keep our delay, we must get scheduled. Even if there is nothing enqueued anymore.
+			manager.ScheduleFeedDispatch(selfHandle, settings.dispatchDelay);
+		}
+		else
+		{
+			manager.ScheduleFeedDispatchNextFrame(selfHandle);
 		}
 	}
+	// Works through the cascade when we were the outermost dispatch.
+	manager.EndFeedDispatch();
 }
@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneReplay.h"
+#include "NotificationBackboneCapture.h"
+#include "NotificationBackboneManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+
+TSharedPtr<FNotificationBackboneReplay> FNotificationBackboneReplay::Open(const FString& path)
+{
+	TUniquePtr<FArchive> reader(IFileManager::Get().CreateFileReader(*path));
+	if (!reader.IsValid())
+	{
+		MF_LOG(Warning, false, "Could not open the capture %s", *path);
+		return nullptr;
+	}
+
+	uint32 magic = 0;
+	uint32 version = 0;
+	*reader << magic << version;
+	if (reader->IsError() || magic != FNotificationBackboneCapture::Magic || version != FNotificationBackboneCapture::Version)
+	{
+		MF_LOG(Warning, false, "%s is no capture of this version. Magic: %x, Version: %u", *path, magic, version);
+		return nullptr;
+	}
+
+	TSharedPtr<FNotificationBackboneReplay> replay = MakeShareable(new FNotificationBackboneReplay(path, MoveTemp(reader)));
+	replay->ReadNext();
+	return replay;
+}
+
+FNotificationBackboneReplay::FNotificationBackboneReplay(const FString& in_path, TUniquePtr<FArchive>&& in_reader)
+	: path(in_path), reader(MoveTemp(in_reader))
+{
+}
+
+FNotificationBackboneReplay::~FNotificationBackboneReplay()
+{
+	Stop();
+}
+
+void FNotificationBackboneReplay::Start(float in_speed, int32 in_maxPerTick, float in_frameSeconds)
+{
+	check(IsInGameThread());
+	Stop();
+
+	speed = FMath::Max(in_speed, 0.f);
+	maxPerTick = FMath::Max(in_maxPerTick, 0);
+	frameSeconds = FMath::Max(in_frameSeconds, KINDA_SMALL_NUMBER);
+	startSeconds = FPlatformTime::Seconds();
+	tickerDelegateHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FNotificationBackboneReplay::Tick));
+
+	MF_LOG(Log, false, "Replaying %s at speed %.2f", *path, speed);
+}
+
+void FNotificationBackboneReplay::Stop()
+{
+	if (tickerDelegateHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(tickerDelegateHandle);
+		tickerDelegateHandle.Reset();
+	}
+}
+
+bool FNotificationBackboneReplay::Tick(float deltaSeconds)
+{
+	if (Advance(deltaSeconds))
+	{
+		return true;
+	}
+
+	MF_LOG(Log, false, "Replayed %llu notifications of %s in %.2f seconds", numReplayed, *path, FPlatformTime::Seconds() - startSeconds);
+	// The ticker removes us when we return false.
+	tickerDelegateHandle.Reset();
+	return false;
+}
+
+bool FNotificationBackboneReplay::Advance(float elapsedSeconds)
+{
+	if (speed > 0.f)
+	{
+		replaySeconds += elapsedSeconds * speed;
+	}
+	else
+	{
+		// One frame of the capture per tick, whatever time passed. Frames where nothing happened get skipped.
+		if (bHasPending && pendingSeconds > replaySeconds)
+		{
+			replaySeconds = pendingSeconds;
+		}
+		replaySeconds += frameSeconds;
+	}
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	int32 numThisTick = 0;
+	while (bHasPending && pendingSeconds <= replaySeconds && (maxPerTick == 0 || numThisTick < maxPerTick))
+	{
+		manager.DispatchNotification(pendingNotification);
+		++numReplayed;
+		++numThisTick;
+		ReadNext();
+	}
+	return bHasPending;
+}
+
+bool FNotificationBackboneReplay::ReadNext()
+{
+	bHasPending = false;
+	if (reader->AtEnd())
+	{
+		return false;
+	}
+
+	uint32 deltaMicroseconds = 0;
+	reader->SerializeIntPacked(deltaMicroseconds);
+
+	pendingNotification = FNotificationBackboneNotification();
+	pendingNotification.feed = ReadName();
+	pendingNotification.coalescingKey = ReadName();
+	pendingNotification.routingKey = ReadName();
+	uint8 priority = 0;
+	*reader << priority;
+	pendingNotification.priority = (ENotificationBackbonePriority)FMath::Min<uint8>(priority, (uint8)ENotificationBackbonePriority::Critical);
+
+	FString title;
+	FString message;
+	FString icon;
+	FString json;
+	*reader << title << message << icon << json;
+	if (reader->IsError())
+	{
+		MF_LOG(Warning, false, "The capture %s is broken after %llu notifications", *path, numReplayed);
+		return false;
+	}
+
+	pendingNotification.title = FText::FromString(title);
+	pendingNotification.message = FText::FromString(message);
+	if (!icon.IsEmpty())
+	{
+		pendingNotification.softIcon = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(icon));
+	}
+	if (!json.IsEmpty())
+	{
+		pendingNotification.SetJson(json);
+	}
+
+	pendingSeconds += deltaMicroseconds / 1000000.0;
+	bHasPending = true;
+	return true;
+}
+
+FName FNotificationBackboneReplay::ReadName()
+{
+	uint32 index = 0;
+	reader->SerializeIntPacked(index);
+	if (index == (uint32)names.Num())
+	{
+		// First time, the name follows.
+		FString nameString;
+		*reader << nameString;
+		names.Add(FName(*nameString));
+	}
+	return names.IsValidIndex(index) ? names[index] : NAME_None;
+}
+
+UNotificationBackboneReplayCommandlet::UNotificationBackboneReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UNotificationBackboneReplayCommandlet::Main(const FString& params)
+{
+	FString path;
+	float speed = 1.f;
+	float framesPerSecond = 60.f;
+	FParse::Value(*params, TEXT("file="), path);
+	FParse::Value(*params, TEXT("speed="), speed);
+	FParse::Value(*params, TEXT("fps="), framesPerSecond);
+
+	TSharedPtr<FNotificationBackboneReplay> replay = FNotificationBackboneReplay::Open(path);
+	if (!replay.IsValid())
+	{
+		return 1;
+	}
+
+	// Fixed frame time, so the same capture gets dispatched in the same frames every run.
+	const float frameSeconds = 1.f / FMath::Max(framesPerSecond, 1.f);
+	replay->Start(speed, 0, frameSeconds);
+	while (!replay->IsFinished())
+	{
+		const double frameStartSeconds = FPlatformTime::Seconds();
+		TickFrame(frameSeconds);
+		if (speed > 0.f)
+		{
+			// Keep the pace of the capture, async work of the listeners gets the time it had.
+			const double remainingSeconds = frameSeconds - (FPlatformTime::Seconds() - frameStartSeconds);
+			if (remainingSeconds > 0.0)
+			{
+				FPlatformProcess::Sleep((float)remainingSeconds);
+			}
+		}
+	}
+	// What was dispatched last still has to go out of the delayed feeds.
+	TickFrame(frameSeconds);
+
+	IConsoleManager::Get().ProcessUserConsoleInput(TEXT("NotificationBackbone.DumpStats"), *GLog, nullptr);
+	return 0;
+}
+
+void UNotificationBackboneReplayCommandlet::TickFrame(float frameSeconds)
+{
+	FTicker::GetCoreTicker().Tick(frameSeconds);
+	// Nobody else runs the game thread tasks in a commandlet, e.g. the completions of async listeners.
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+}
+
+#pragma region Console
+namespace NotificationBackboneConsole
+{
+	static TSharedPtr<FNotificationBackboneReplay> activeReplay;
+
+	static void Replay(const TArray<FString>& args)
+	{
+		if (args.Num() < 1)
+		{
+			MF_LOG(Warning, false, "Usage: NotificationBackbone.Replay <File> [Speed, 0 as fast as possible, one frame per tick] [MaxPerTick]");
+			return;
+		}
+
+		activeReplay = FNotificationBackboneReplay::Open(args[0]);
+		if (activeReplay.IsValid())
+		{
+			activeReplay->Start(args.Num() > 1 ? FCString::Atof(*args[1]) : 1.f, args.Num() > 2 ? FCString::Atoi(*args[2]) : 0);
+		}
+	}
+
+	static void StopReplay(const TArray<FString>& args)
+	{
+		activeReplay.Reset();
+	}
+
+	static FAutoConsoleCommand ReplayCommand(
+		TEXT("NotificationBackbone.Replay"),
+		TEXT("Dispatches the notifications of a capture again. <File> [Speed, 0 as fast as possible, one frame per tick] [MaxPerTick]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Replay));
+
+	static FAutoConsoleCommand StopReplayCommand(
+		TEXT("NotificationBackbone.StopReplay"),
+		TEXT("Stops the replay started with NotificationBackbone.Replay."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StopReplay));
+}
+#pragma endregion Console
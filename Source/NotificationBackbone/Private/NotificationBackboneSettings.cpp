@@ -1,7 +1,79 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "NotificationBackboneSettings.h"
+#include "NotificationBackboneFeedPattern.h"
+#include "NotificationBackboneManager.h"
 
+const FNotificationBackboneFeedSettings* UNotificationBackboneSettings::FindFeedSettings(const FName& feed) const
+{
+	const int32* index = feedSettingsIndex.Find(feed);
+	if (index)
+	{
+		return &feedSettings[*index];
+	}
 
+	if (patternFeedSettings.Num() > 0)
+	{
+		TArray<FName> feedSegments;
+		FNotificationBackboneFeedPattern::Split(feed, feedSegments);
+		for (const TPair<TArray<FName>, int32>& pattern : patternFeedSettings)
+		{
+			if (FNotificationBackboneFeedPattern::Matches(pattern.Key, feedSegments))
+			{
+				return &feedSettings[pattern.Value];
+			}
+		}
+	}
+	return nullptr;
+}
 
+void UNotificationBackboneSettings::PostInitProperties()
+{
+	Super::PostInitProperties();
+	// Too early to bother the manager, there are no feeds yet.
+	RebuildFeedSettingsIndex();
+}
 
+void UNotificationBackboneSettings::PostReloadConfig(UProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+	OnFeedSettingsChanged();
+}
+
+#if WITH_EDITOR
+void UNotificationBackboneSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	OnFeedSettingsChanged();
+}
+#endif
+
+void UNotificationBackboneSettings::OnFeedSettingsChanged()
+{
+	RebuildFeedSettingsIndex();
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		FNotificationBackboneManager::Get().ReloadFeedSettings();
+	}
+}
+
+void UNotificationBackboneSettings::RebuildFeedSettingsIndex()
+{
+	feedSettingsIndex.Reset();
+	patternFeedSettings.Reset();
+	for (int32 index = 0; index < feedSettings.Num(); ++index)
+	{
+		const FName& feed = feedSettings[index].feed;
+		if (FNotificationBackboneFeedPattern::IsPattern(feed))
+		{
+			TPair<TArray<FName>, int32> pattern;
+			FNotificationBackboneFeedPattern::Split(feed, pattern.Key);
+			pattern.Value = index;
+			patternFeedSettings.Add(MoveTemp(pattern));
+		}
+		else if (!feedSettingsIndex.Contains(feed))
+		{
+			feedSettingsIndex.Add(feed, index);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneStats.h"
+
+DEFINE_STAT(STAT_NotificationBackbone_DispatchNotification);
+DEFINE_STAT(STAT_NotificationBackbone_DispatchNotificationFromQueue);
+DEFINE_STAT(STAT_NotificationBackbone_NotifyListeners);
+DEFINE_STAT(STAT_NotificationBackbone_AsyncListener);
+DEFINE_STAT(STAT_NotificationBackbone_FlushIncomingNotifications);
+DEFINE_STAT(STAT_NotificationBackbone_Tick);
+DEFINE_STAT(STAT_NotificationBackbone_NumDispatched);
+
+static int32 ClampToInt32(uint64 value)
+{
+	return (int32)FMath::Min<uint64>(value, MAX_int32);
+}
+
+static float CyclesToMilliseconds(uint64 cycles)
+{
+	return (float)(cycles * FPlatformTime::GetSecondsPerCycle64() * 1000.0);
+}
+
+void FNotificationBackboneFeedCounters::RecordLatency(uint64 latencyCycles)
+{
+	const uint64 latencyMicroseconds = (uint64)(latencyCycles * FPlatformTime::GetSecondsPerCycle64() * 1000000.0);
+	const int32 bucket = latencyMicroseconds == 0 ? 0 : FMath::Min<int32>(FMath::FloorLog2_64(latencyMicroseconds) + 1, NumLatencyBuckets - 1);
+	++latencyHistogram[bucket];
+	totalLatencyCycles += latencyCycles;
+	maxLatencyCycles = FMath::Max(maxLatencyCycles, latencyCycles);
+}
+
+void FNotificationBackboneFeedCounters::Append(const FNotificationBackboneFeedCounters& other)
+{
+	numEnqueued += other.numEnqueued;
+	numCoalesced += other.numCoalesced;
+	numDispatched += other.numDispatched;
+	numDroppedNoListeners += other.numDroppedNoListeners;
+	numDroppedOverflow += other.numDroppedOverflow;
+	numCleared += other.numCleared;
+	maxQueuedNotifications = FMath::Max(maxQueuedNotifications, other.maxQueuedNotifications);
+
+	for (int32 bucket = 0; bucket < NumLatencyBuckets; ++bucket)
+	{
+		latencyHistogram[bucket] += other.latencyHistogram[bucket];
+	}
+	totalLatencyCycles += other.totalLatencyCycles;
+	maxLatencyCycles = FMath::Max(maxLatencyCycles, other.maxLatencyCycles);
+
+	listenerCycles += other.listenerCycles;
+	if (other.slowestListenerCycles > slowestListenerCycles)
+	{
+		slowestListenerCycles = other.slowestListenerCycles;
+		slowestListener = other.slowestListener;
+	}
+}
+
+double FNotificationBackboneFeedCounters::GetLatencyPercentileMicroseconds(double fraction) const
+{
+	uint64 numLatencies = 0;
+	for (int32 bucket = 0; bucket < NumLatencyBuckets; ++bucket)
+	{
+		numLatencies += latencyHistogram[bucket];
+	}
+	if (numLatencies == 0)
+	{
+		return 0.0;
+	}
+
+	const uint64 rank = FMath::Max<uint64>((uint64)FMath::CeilToDouble(numLatencies * fraction), 1);
+	uint64 numBelow = 0;
+	for (int32 bucket = 0; bucket < NumLatencyBuckets - 1; ++bucket)
+	{
+		numBelow += latencyHistogram[bucket];
+		if (numBelow >= rank)
+		{
+			return (double)(1ull << bucket);
+		}
+	}
+	// The last bucket has no upper bound, the max is the best we know.
+	return maxLatencyCycles * FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+}
+
+void FNotificationBackboneFeedCounters::ToStats(FNotificationBackboneFeedStats& outStats) const
+{
+	outStats.numEnqueued = ClampToInt32(numEnqueued);
+	outStats.numCoalesced = ClampToInt32(numCoalesced);
+	outStats.numDispatched = ClampToInt32(numDispatched);
+	outStats.numDroppedNoListeners = ClampToInt32(numDroppedNoListeners);
+	outStats.numDroppedOverflow = ClampToInt32(numDroppedOverflow);
+	outStats.numCleared = ClampToInt32(numCleared);
+	outStats.maxQueuedNotifications = ClampToInt32(maxQueuedNotifications);
+
+	outStats.averageLatencyMilliseconds = numDispatched > 0 ? CyclesToMilliseconds(totalLatencyCycles) / numDispatched : 0.f;
+	outStats.latencyP50Milliseconds = (float)(GetLatencyPercentileMicroseconds(0.5) / 1000.0);
+	outStats.latencyP90Milliseconds = (float)(GetLatencyPercentileMicroseconds(0.9) / 1000.0);
+	outStats.latencyP99Milliseconds = (float)(GetLatencyPercentileMicroseconds(0.99) / 1000.0);
+	outStats.maxLatencyMilliseconds = CyclesToMilliseconds(maxLatencyCycles);
+
+	outStats.latencyHistogram.SetNumUninitialized(NumLatencyBuckets);
+	for (int32 bucket = 0; bucket < NumLatencyBuckets; ++bucket)
+	{
+		outStats.latencyHistogram[bucket] = ClampToInt32(latencyHistogram[bucket]);
+	}
+
+	outStats.listenerMilliseconds = CyclesToMilliseconds(listenerCycles);
+	outStats.slowestListener = slowestListener;
+	outStats.slowestListenerMilliseconds = CyclesToMilliseconds(slowestListenerCycles);
+}
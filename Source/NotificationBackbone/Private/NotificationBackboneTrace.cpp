@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTrace.h"
+
+uint64 FNotificationBackboneTrace::lastNotificationId = 0;
+
+#if NOTIFICATIONBACKBONE_UE_TRACE
+
+#if ENGINE_MAJOR_VERSION > 4
+#define NOTIFICATIONBACKBONE_TRACE_WIDESTRING UE::Trace::WideString
+#else
+#define NOTIFICATIONBACKBONE_TRACE_WIDESTRING Trace::WideString
+#endif
+
+UE_TRACE_CHANNEL_DEFINE(NotificationBackboneChannel)
+
+UE_TRACE_EVENT_BEGIN(NotificationBackbone, NotificationEvent)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, NotificationId)
+	UE_TRACE_EVENT_FIELD(uint8, Event)
+	UE_TRACE_EVENT_FIELD(uint32, Value)
+	UE_TRACE_EVENT_FIELD(NOTIFICATIONBACKBONE_TRACE_WIDESTRING, Feed)
+	UE_TRACE_EVENT_FIELD(NOTIFICATIONBACKBONE_TRACE_WIDESTRING, Listener)
+UE_TRACE_EVENT_END()
+
+void FNotificationBackboneTrace::OutputEvent(ENotificationBackboneTraceEvent event, uint64 notificationId, const FName& feed, const FName& listener, uint32 value)
+{
+	const FString feedString = feed.ToString();
+	const FString listenerString = listener.IsNone() ? FString() : listener.ToString();
+	UE_TRACE_LOG(NotificationBackbone, NotificationEvent, NotificationBackboneChannel)
+		<< NotificationEvent.Cycle(FPlatformTime::Cycles64())
+		<< NotificationEvent.NotificationId(notificationId)
+		<< NotificationEvent.Event((uint8)event)
+		<< NotificationEvent.Value(value)
+		<< NotificationEvent.Feed(*feedString, feedString.Len())
+		<< NotificationEvent.Listener(*listenerString, listenerString.Len());
+}
+
+#else
+
+DEFINE_LOG_CATEGORY(LogNotificationBackboneTrace);
+
+void FNotificationBackboneTrace::OutputEvent(ENotificationBackboneTraceEvent event, uint64 notificationId, const FName& feed, const FName& listener, uint32 value)
+{
+	static const TCHAR* const eventNames[] = { TEXT("Enqueue"), TEXT("Coalesce"), TEXT("Block"), TEXT("Unblock"), TEXT("Dequeue"), TEXT("ListenerBegin"), TEXT("ListenerEnd"), TEXT("Drop"), TEXT("Clear") };
+	UE_LOG(LogNotificationBackboneTrace, Verbose, TEXT("%.6f %s Id=%llu Feed=%s Listener=%s Value=%u"),
+		FPlatformTime::Seconds(), eventNames[(uint8)event], notificationId, *feed.ToString(), *listener.ToString(), value);
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+#include "NotificationBackboneJson.h"
+#include "Engine/Texture2D.h"
+#include "HAL/Event.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NotificationBackboneTest
+{
+	// Notes down the titles it gets on the workers. Blocks on gate for the first one, if set.
+	class FAsyncListener : public INotificationBackboneListenerRaw
+	{
+	public:
+		virtual void OnNotification(const FNotificationBackboneNotification& notification) override
+		{
+			if (gate && titles.Num() == 0)
+			{
+				gate->Wait();
+			}
+
+			FScopeLock scopeLock(&lock);
+			titles.Add(notification.GetTitle().ToString());
+			numOnGameThread += IsInGameThread() ? 1 : 0;
+			if (notification.json.IsValid())
+			{
+				TSharedPtr<FJsonObject> jsonObject = notification.json->ParseObject();
+				jsonValues.Add(jsonObject.IsValid() ? (int32)jsonObject->GetNumberField(TEXT("value")) : INDEX_NONE);
+			}
+		}
+
+		virtual FName GetNotificationBackboneListenerName() override
+		{
+			return FName("NotificationBackboneTest");
+		}
+
+		FCriticalSection lock;
+		TArray<FString> titles;
+		TArray<int32> jsonValues;
+		int32 numOnGameThread = 0;
+		FEvent* gate = nullptr;
+	};
+}
+
+using namespace NotificationBackboneTest;
+
+// Async listeners get the notifications of a feed in order, off the game thread. The icon of a dispatch outlives a garbage collection
+// while they are still busy with it.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneAsyncListenerTest, "NotificationBackbone.Listeners.Async", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneAsyncListenerTest::RunTest(const FString& parameters)
+{
+	const int32 numNotifications = 500;
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.AsyncListener")));
+	const FName feed = scopedFeed.feed;
+
+	TSharedRef<FAsyncListener> listener = MakeShareable(new FAsyncListener());
+	listener->gate = FPlatformProcess::GetSynchEventFromPool(true);
+	FNotificationBackboneListenerOptions asyncOptions;
+	asyncOptions.bAsync = true;
+	manager.RegisterForNotifications(listener, feed, asyncOptions);
+
+	// Nothing but the dispatch references the icon.
+	UTexture2D* icon = NewObject<UTexture2D>(GetTransientPackage());
+	TWeakObjectPtr<UTexture2D> weakIcon(icon);
+	FNotificationBackboneNotification first = MakeNotification(feed, TEXT("0"));
+	first.icon = icon;
+	first.SetJson(TEXT("{\"value\": 7}"));
+	manager.DispatchNotification(first);
+	first.icon = nullptr;
+	icon = nullptr;
+
+	TArray<FString> expectedTitles;
+	expectedTitles.Add(TEXT("0"));
+	for (int32 index = 1; index < numNotifications; ++index)
+	{
+		expectedTitles.Add(FString::FromInt(index));
+		manager.DispatchNotification(MakeNotification(feed, expectedTitles.Last()));
+	}
+
+	// The listener still waits in the first call.
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	TestTrue(TEXT("Icon is alive while the listener is busy with it"), weakIcon.IsValid());
+	listener->gate->Trigger();
+
+	FNotificationBackboneNotificationFeed* pfeed = manager.GetNotificationFeed(feed);
+	FGraphEventRef completion = pfeed ? pfeed->GetAsyncListenerCompletion() : nullptr;
+	if (completion.IsValid())
+	{
+		// Runs the completions on the game thread meanwhile.
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(completion, ENamedThreads::GameThread);
+	}
+
+	TestTrue(TEXT("Notifications in the order they got dispatched"), listener->titles == expectedTitles);
+	TestEqual(TEXT("Calls on the game thread"), listener->numOnGameThread, 0);
+	TestTrue(TEXT("JSON parsed on the worker"), listener->jsonValues.Num() == 1 && listener->jsonValues[0] == 7);
+
+	manager.UnregisterFromNotifications(listener, feed);
+	FPlatformProcess::ReturnSynchEventToPool(listener->gate);
+	listener->gate = nullptr;
+	return true;
+}
+
+#endif
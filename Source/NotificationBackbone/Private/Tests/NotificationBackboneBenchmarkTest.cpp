@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneBenchmark.h"
+#include "NotificationBackboneTestHelpers.h"
+#include "Misc/CommandLine.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Ticks the benchmark once per frame, the engine ticks the manager in between. Writes the results once it is done.
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FNotificationBackboneBenchmarkCommand, TSharedRef<FNotificationBackboneBenchmark>, benchmark, FAutomationTestBase*, test);
+
+bool FNotificationBackboneBenchmarkCommand::Update()
+{
+	if (!benchmark->Tick())
+	{
+		return false;
+	}
+
+	for (const FNotificationBackboneBenchmarkResult& result : benchmark->GetResults())
+	{
+		test->AddInfo(FString::Printf(TEXT("%s (%d listeners): %.1f/s, p50 %.2f us, p99 %.2f us"),
+			*result.scenario, result.numListeners, result.samplesPerSecond, result.p50Microseconds, result.p99Microseconds));
+	}
+
+	FString basePath;
+	if (benchmark->WriteResults(basePath))
+	{
+		test->AddInfo(FString::Printf(TEXT("Results written to %s.csv and .json"), *basePath));
+	}
+	else
+	{
+		test->AddError(FString::Printf(TEXT("Could not write the results to %s"), *basePath));
+	}
+	return true;
+}
+
+// Not a correctness test, it only fails when the results can't be written. In the performance filter, so it only runs when asked for.
+// Options come from the command line, see README.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneBenchmarkTest, "Benchmarks.NotificationBackbone",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FNotificationBackboneBenchmarkTest::RunTest(const FString& parameters)
+{
+	TSharedRef<FNotificationBackboneBenchmark> benchmark =
+		MakeShareable(new FNotificationBackboneBenchmark(FNotificationBackboneBenchmark::ParseOptions(FCommandLine::Get())));
+	ADD_LATENT_AUTOMATION_COMMAND(FNotificationBackboneBenchmarkCommand(benchmark, this));
+	return true;
+}
+
+#endif
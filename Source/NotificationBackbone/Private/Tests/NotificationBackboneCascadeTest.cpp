@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace NotificationBackboneTest;
+
+// What listeners dispatch while a feed drains a batch goes once the whole batch is done, breadth-first.
+// That includes the feed itself, it must not drain again from within its own batch.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneCascadeOrderTest, "NotificationBackbone.Cascade.BatchOrder", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneCascadeOrderTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed root(FName(TEXT("NotificationBackboneTest.Cascade.Root")), [](FNotificationBackboneFeedSettings& settings)
+	{
+		settings.bCacheNotificationsNoListeners = true;
+	});
+	FScopedFeed child(FName(TEXT("NotificationBackboneTest.Cascade.Child")));
+
+	TArray<FString> order;
+	TSharedRef<FListener> childListener = MakeShareable(new FListener());
+	childListener->onNotification = [&order](const FNotificationBackboneNotification& notification)
+	{
+		order.Add(notification.GetTitle().ToString());
+	};
+	manager.RegisterForNotifications(childListener, child.feed);
+
+	TSharedRef<FListener> rootListener = MakeShareable(new FListener());
+	rootListener->onNotification = [&manager, &order, &root, &child](const FNotificationBackboneNotification& notification)
+	{
+		const FString title = notification.GetTitle().ToString();
+		order.Add(title);
+		if (title == TEXT("Root1"))
+		{
+			manager.DispatchNotification(MakeNotification(child.feed, TEXT("Child1")));
+			manager.DispatchNotification(MakeNotification(root.feed, TEXT("RootAgain")));
+		}
+	};
+
+	// The cached notifications go out as one batch once the listener subscribes.
+	manager.DispatchNotification(MakeNotification(root.feed, TEXT("Root1")));
+	manager.DispatchNotification(MakeNotification(root.feed, TEXT("Root2")));
+	manager.DispatchNotification(MakeNotification(root.feed, TEXT("Root3")));
+	manager.RegisterForNotifications(rootListener, root.feed);
+
+	TArray<FString> expectedOrder;
+	expectedOrder.Add(TEXT("Root1"));
+	expectedOrder.Add(TEXT("Root2"));
+	expectedOrder.Add(TEXT("Root3"));
+	expectedOrder.Add(TEXT("Child1"));
+	expectedOrder.Add(TEXT("RootAgain"));
+	TestTrue(TEXT("Batch first, then the cascade in the order it got deferred"), order == expectedOrder);
+
+	rootListener->onNotification = nullptr;
+	childListener->onNotification = nullptr;
+	manager.UnregisterFromNotifications(rootListener, root.feed);
+	manager.UnregisterFromNotifications(childListener, child.feed);
+	return true;
+}
+
+#endif
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+#include "NotificationChannel.h"
+#include "Async/Async.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NotificationBackboneTest
+{
+	struct FChannelPayload
+	{
+		int32 value = 0;
+	};
+}
+
+NOTIFICATIONBACKBONE_CHANNEL_PAYLOAD(NotificationBackboneTest::FChannelPayload)
+
+namespace NotificationBackboneTest
+{
+	typedef TNotificationChannel<FChannelPayload> FTestChannel;
+
+	// Notes down the values it gets. Then calls onPayload, if set.
+	class FChannelListener : public FTestChannel::FListener
+	{
+	public:
+		virtual void OnChannelNotification(const FChannelPayload& payload) override
+		{
+			values.Add(payload.value);
+			if (onPayload)
+			{
+				onPayload(payload);
+			}
+		}
+
+		virtual FName GetNotificationBackboneListenerName() override
+		{
+			return FName("NotificationBackboneTest");
+		}
+
+		TArray<int32> values;
+		TFunction<void(const FChannelPayload&)> onPayload;
+	};
+
+	static FChannelPayload MakePayload(int32 value)
+	{
+		FChannelPayload payload;
+		payload.value = value;
+		return payload;
+	}
+}
+
+using namespace NotificationBackboneTest;
+
+// Listeners that subscribe during a dispatch wait for it to end. Unsubscribing them again before, or subscribing them twice, must stick.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneChannelPendingListenerTest, "NotificationBackbone.Channels.ListenersDuringDispatch", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneChannelPendingListenerTest::RunTest(const FString& parameters)
+{
+	FTestChannel::FChannelRef channel = FTestChannel::Get(FName(TEXT("NotificationBackboneTest.PendingListeners")));
+
+	TSharedRef<FChannelListener> dispatcher = MakeShareable(new FChannelListener());
+	TSharedRef<FChannelListener> leaving = MakeShareable(new FChannelListener());
+	TSharedRef<FChannelListener> doubled = MakeShareable(new FChannelListener());
+	dispatcher->onPayload = [&channel, &leaving, &doubled](const FChannelPayload& payload)
+	{
+		if (payload.value == 1)
+		{
+			channel->RegisterListener(leaving);
+			channel->UnregisterListener(leaving);
+			channel->RegisterListener(doubled);
+			channel->RegisterListener(doubled);
+		}
+	};
+
+	channel->RegisterListener(dispatcher);
+	channel->Dispatch(MakePayload(1));
+	channel->Dispatch(MakePayload(2));
+	channel->Dispatch(MakePayload(3));
+
+	TestEqual(TEXT("Payloads of the listener that left during the dispatch"), leaving->values.Num(), 0);
+	TArray<int32> expectedValues;
+	expectedValues.Add(2);
+	expectedValues.Add(3);
+	TestTrue(TEXT("Payloads of the listener that subscribed twice during the dispatch"), doubled->values == expectedValues);
+
+	TArray<FString> listenerNames;
+	channel->GetListenerNames(listenerNames);
+	TestEqual(TEXT("Listeners of the channel"), listenerNames.Num(), 2);
+
+	dispatcher->onPayload = nullptr;
+	channel->UnregisterListener(dispatcher);
+	channel->UnregisterListener(doubled);
+	return true;
+}
+
+// Channels live in the manager, so every module gets the same channel for a name. The manager drains their inboxes.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneChannelRegistryTest, "NotificationBackbone.Channels.SharedRegistry", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneChannelRegistryTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	const FName name(TEXT("NotificationBackboneTest.Registry"));
+	FTestChannel::FChannelRef channel = FTestChannel::Get(name);
+
+	TestTrue(TEXT("Same channel for the same name"), &FTestChannel::Get(name).Get() == &channel.Get());
+	TestTrue(TEXT("Channel is kept by the manager"),
+		manager.FindChannel(TNotificationChannelPayloadName<FChannelPayload>::Get(), name).Get() == &channel.Get());
+	TestFalse(TEXT("Other names get other channels"), &FTestChannel::Get(FName(TEXT("NotificationBackboneTest.RegistryOther"))).Get() == &channel.Get());
+
+	TSharedRef<FChannelListener> listener = MakeShareable(new FChannelListener());
+	channel->RegisterListener(listener);
+
+	const int32 numPayloads = 1000;
+	Async<void>(EAsyncExecution::Thread, [channel, numPayloads]()
+	{
+		for (int32 value = 0; value < numPayloads; ++value)
+		{
+			channel->Dispatch(MakePayload(value));
+		}
+	}).Wait();
+	TestEqual(TEXT("Payloads from another thread before the inbox got drained"), listener->values.Num(), 0);
+
+	manager.FlushIncomingNotifications();
+	TestEqual(TEXT("Payloads from another thread after the inbox got drained"), listener->values.Num(), numPayloads);
+
+	channel->UnregisterListener(listener);
+	return true;
+}
+
+#endif
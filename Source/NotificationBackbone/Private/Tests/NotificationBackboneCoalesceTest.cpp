@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NotificationBackboneTest
+{
+	// Notes down title and coalesced count, e.g. "A2x2".
+	static void RecordCoalescedCount(FListener& listener, TArray<FString>& outRecords)
+	{
+		listener.onNotification = [&outRecords](const FNotificationBackboneNotification& notification)
+		{
+			outRecords.Add(FString::Printf(TEXT("%sx%d"), *notification.GetTitle().ToString(), notification.coalescedCount));
+		};
+	}
+
+	static FNotificationBackboneNotification MakeKeyedNotification(const FName& feed, const FString& title, const FName& coalescingKey,
+		ENotificationBackbonePriority priority = ENotificationBackbonePriority::Normal)
+	{
+		FNotificationBackboneNotification notification = MakeNotification(feed, title);
+		notification.coalescingKey = coalescingKey;
+		notification.priority = priority;
+		return notification;
+	}
+}
+
+using namespace NotificationBackboneTest;
+
+static const FName CoalesceTestKey(TEXT("Key"));
+
+// Notifications with the same key merge into the queued one, with the merge function of the feed or by replacing it.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneCoalesceMergeTest, "NotificationBackbone.Coalescing.Merge", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneCoalesceMergeTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.CoalesceMerge")), [](FNotificationBackboneFeedSettings& settings)
+	{
+		settings.bCacheNotificationsNoListeners = true;
+		settings.coalesceMode = ENotificationBackboneCoalesceMode::Merge;
+	});
+	const FName feed = scopedFeed.feed;
+	manager.SetNotificationFeedMergeFunction(feed, FOnNotificationBackboneMerge::CreateLambda(
+		[](FNotificationBackboneNotification& queued, const FNotificationBackboneNotification& incoming)
+	{
+		queued.title = FText::FromString(queued.GetTitle().ToString() + incoming.GetTitle().ToString());
+	}));
+
+	TestEqual(TEXT("First keyed notification"), (int32)manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("A"), CoalesceTestKey)),
+		(int32)ENotificationBackboneDispatchResult::Queued);
+	manager.DispatchNotification(MakeNotification(feed, TEXT("Other")));
+	TestEqual(TEXT("Second keyed notification"), (int32)manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("B"), CoalesceTestKey)),
+		(int32)ENotificationBackboneDispatchResult::Coalesced);
+
+	TArray<FString> records;
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	RecordCoalescedCount(*listener, records);
+	manager.RegisterForNotifications(listener, feed);
+
+	TArray<FString> expectedRecords;
+	expectedRecords.Add(TEXT("ABx2"));
+	expectedRecords.Add(TEXT("Otherx1"));
+	TestTrue(TEXT("Merged notification keeps its place"), records == expectedRecords);
+
+	// Dispatched, so the key starts over.
+	records.Reset();
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("C"), CoalesceTestKey));
+	TestTrue(TEXT("Key of a dispatched notification"), records.Num() == 1 && records[0] == TEXT("Cx1"));
+
+	listener->onNotification = nullptr;
+	manager.UnregisterFromNotifications(listener, feed);
+	manager.SetNotificationFeedMergeFunction(feed, FOnNotificationBackboneMerge());
+	return true;
+}
+
+// A keyed notification dropped to make room must take its key along, the next one with the key gets queued on its own.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneCoalesceDropOldestTest, "NotificationBackbone.Coalescing.DropOldest", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneCoalesceDropOldestTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.CoalesceDropOldest")), [](FNotificationBackboneFeedSettings& settings)
+	{
+		settings.bCacheNotificationsNoListeners = true;
+		settings.coalesceMode = ENotificationBackboneCoalesceMode::ReplaceLatest;
+		settings.maxQueuedNotifications = 1;
+		settings.overflowPolicy = ENotificationBackboneOverflowPolicy::DropOldest;
+	});
+	const FName feed = scopedFeed.feed;
+
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("A"), CoalesceTestKey));
+	TestEqual(TEXT("Notification that drops the keyed one"), (int32)manager.DispatchNotification(MakeNotification(feed, TEXT("Other"))),
+		(int32)ENotificationBackboneDispatchResult::QueuedDroppedOldest);
+	TestEqual(TEXT("Keyed notification after its key got dropped"), (int32)manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("B"), CoalesceTestKey)),
+		(int32)ENotificationBackboneDispatchResult::QueuedDroppedOldest);
+	TestEqual(TEXT("Keyed notification while its key is queued"), (int32)manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("C"), CoalesceTestKey)),
+		(int32)ENotificationBackboneDispatchResult::Coalesced);
+
+	TArray<FString> records;
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	RecordCoalescedCount(*listener, records);
+	manager.RegisterForNotifications(listener, feed);
+
+	TestTrue(TEXT("Only the last keyed notification"), records.Num() == 1 && records[0] == TEXT("Cx2"));
+
+	listener->onNotification = nullptr;
+	manager.UnregisterFromNotifications(listener, feed);
+	return true;
+}
+
+// Aging serves a lower lane ahead of a higher one. The keyed notification behind must still be found in its lane,
+// also by notifications of another priority, and dispatched once.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneCoalesceAgingTest, "NotificationBackbone.Coalescing.PriorityAging", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneCoalesceAgingTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.CoalesceAging")), [](FNotificationBackboneFeedSettings& settings)
+	{
+		settings.bCacheNotificationsNoListeners = true;
+		settings.coalesceMode = ENotificationBackboneCoalesceMode::ReplaceLatest;
+		settings.priorityAgingThreshold = 1;
+	});
+	const FName feed = scopedFeed.feed;
+
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("High1"), NAME_None, ENotificationBackbonePriority::High));
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("High2"), NAME_None, ENotificationBackbonePriority::High));
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("Low"), NAME_None, ENotificationBackbonePriority::Low));
+	manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("Keyed"), CoalesceTestKey, ENotificationBackbonePriority::Low));
+
+	// Once the aged lane got served, a high priority notification with the key comes in while the feed dispatches.
+	TArray<FString> records;
+	ENotificationBackboneDispatchResult coalesceResult = ENotificationBackboneDispatchResult::Queued;
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	listener->onNotification = [&manager, &records, &coalesceResult, &feed](const FNotificationBackboneNotification& notification)
+	{
+		const FString title = notification.GetTitle().ToString();
+		records.Add(FString::Printf(TEXT("%sx%d"), *title, notification.coalescedCount));
+		if (title == TEXT("Low"))
+		{
+			coalesceResult = manager.DispatchNotification(MakeKeyedNotification(feed, TEXT("KeyedHigh"), CoalesceTestKey, ENotificationBackbonePriority::High));
+		}
+	};
+	manager.RegisterForNotifications(listener, feed);
+
+	TestEqual(TEXT("Keyed notification of another priority"), (int32)coalesceResult, (int32)ENotificationBackboneDispatchResult::Coalesced);
+	TArray<FString> expectedRecords;
+	expectedRecords.Add(TEXT("High1x1"));
+	expectedRecords.Add(TEXT("Lowx1"));
+	expectedRecords.Add(TEXT("High2x1"));
+	expectedRecords.Add(TEXT("KeyedHighx2"));
+	TestTrue(TEXT("Aged lane first, merged notification stays in its lane"), records == expectedRecords);
+
+	listener->onNotification = nullptr;
+	manager.UnregisterFromNotifications(listener, feed);
+	return true;
+}
+
+#endif
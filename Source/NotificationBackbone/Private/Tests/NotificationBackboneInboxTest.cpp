@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+#include "Async/Async.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace NotificationBackboneTest;
+
+// Producer threads flood the inbox while the game thread drains it. Every notification has to arrive exactly once,
+// and the ones of each producer in the order it dispatched them.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneInboxStressTest, "NotificationBackbone.Inbox.Stress", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneInboxStressTest::RunTest(const FString& parameters)
+{
+	const int32 numProducers = 8;
+	const int32 numPerProducer = 10000;
+	const int32 numNotifications = numProducers * numPerProducer;
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.Inbox")));
+	const FName feed = scopedFeed.feed;
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	manager.RegisterForNotifications(listener, feed);
+
+	TArray<TFuture<void>> producers;
+	for (int32 producer = 0; producer < numProducers; ++producer)
+	{
+		producers.Add(Async<void>(EAsyncExecution::Thread, [producer, numPerProducer, feed]()
+		{
+			FNotificationBackboneManager& producerManager = FNotificationBackboneManager::Get();
+			for (int32 index = 0; index < numPerProducer; ++index)
+			{
+				producerManager.DispatchNotification(MakeNotification(feed, FString::FromInt(producer * numPerProducer + index)));
+			}
+		}));
+	}
+
+	// Drain while the producers are still at it, that is when a lost or doubled node would show.
+	bool bProducing = true;
+	while (bProducing)
+	{
+		manager.FlushIncomingNotifications();
+		bProducing = producers.ContainsByPredicate([](const TFuture<void>& producer) { return !producer.IsReady(); });
+	}
+	for (TFuture<void>& producer : producers)
+	{
+		producer.Wait();
+	}
+	manager.FlushIncomingNotifications();
+	manager.UnregisterFromNotifications(listener, feed);
+
+	TArray<int32> counts;
+	counts.SetNumZeroed(numNotifications);
+	TArray<int32> lastIndices;
+	lastIndices.Init(-1, numProducers);
+	int32 numUnknown = 0;
+	int32 numOutOfOrder = 0;
+	for (const FString& title : listener->titles)
+	{
+		const int32 id = FCString::Atoi(*title);
+		if (!counts.IsValidIndex(id))
+		{
+			++numUnknown;
+			continue;
+		}
+		++counts[id];
+
+		const int32 producer = id / numPerProducer;
+		const int32 index = id % numPerProducer;
+		if (index <= lastIndices[producer])
+		{
+			++numOutOfOrder;
+		}
+		lastIndices[producer] = index;
+	}
+
+	int32 numLost = 0;
+	int32 numDuplicated = 0;
+	for (int32 count : counts)
+	{
+		numLost += count == 0 ? 1 : 0;
+		numDuplicated += count > 1 ? count - 1 : 0;
+	}
+
+	TestEqual(TEXT("Received notifications"), listener->titles.Num(), numNotifications);
+	TestEqual(TEXT("Lost notifications"), numLost, 0);
+	TestEqual(TEXT("Duplicated notifications"), numDuplicated, 0);
+	TestEqual(TEXT("Unknown notifications"), numUnknown, 0);
+	TestEqual(TEXT("Notifications out of producer order"), numOutOfOrder, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace NotificationBackboneTest;
+
+// Listeners subscribe and unsubscribe themselves and each other from within their callbacks.
+// Only listeners subscribed when a dispatch starts may get the notification, each at most once,
+// and once the dispatch is over the feed has to have exactly the listeners that are subscribed.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneListenerChurnTest, "NotificationBackbone.Listeners.ChurnDuringDispatch", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneListenerChurnTest::RunTest(const FString& parameters)
+{
+	const int32 numListeners = 64;
+	const int32 numNotifications = 5000;
+
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.ListenerChurn")));
+	const FName feed = scopedFeed.feed;
+
+	TArray<TSharedRef<FListener>> listeners;
+	// Who is subscribed, going by the calls the listeners made.
+	TArray<bool> subscribed;
+	TArray<bool> subscribedAtDispatch;
+	FString currentTitle;
+	FRandomStream random(1234);
+	int32 numUnexpected = 0;
+	int32 numDuplicated = 0;
+
+	for (int32 index = 0; index < numListeners; ++index)
+	{
+		listeners.Add(MakeShareable(new FListener()));
+		subscribed.Add(false);
+	}
+
+	for (int32 index = 0; index < numListeners; ++index)
+	{
+		listeners[index]->onNotification = [&, index](const FNotificationBackboneNotification& notification)
+		{
+			numUnexpected += subscribedAtDispatch[index] ? 0 : 1;
+			const TArray<FString>& titles = listeners[index]->titles;
+			numDuplicated += titles.Num() > 1 && titles[titles.Num() - 2] == currentTitle ? 1 : 0;
+
+			const int32 other = random.RandHelper(numListeners);
+			switch (random.RandHelper(5))
+			{
+			case 0:
+				manager.UnregisterFromNotifications(listeners[other], feed);
+				subscribed[other] = false;
+				break;
+			case 1:
+				manager.RegisterForNotifications(listeners[other], feed);
+				subscribed[other] = true;
+				break;
+			case 2:
+				// Left and back during the same dispatch.
+				manager.UnregisterFromNotifications(listeners[index], feed);
+				manager.RegisterForNotifications(listeners[index], feed);
+				break;
+			case 3:
+				manager.UnregisterFromNotifications(listeners[index], feed);
+				subscribed[index] = false;
+				break;
+			default:
+				break;
+			}
+		};
+	}
+
+	for (int32 index = 0; index < numListeners; index += 2)
+	{
+		manager.RegisterForNotifications(listeners[index], feed);
+		subscribed[index] = true;
+	}
+
+	int32 numMismatched = 0;
+	for (int32 notificationIndex = 0; notificationIndex < numNotifications; ++notificationIndex)
+	{
+		if (!subscribed.Contains(true))
+		{
+			const int32 index = notificationIndex % numListeners;
+			manager.RegisterForNotifications(listeners[index], feed);
+			subscribed[index] = true;
+		}
+
+		subscribedAtDispatch = subscribed;
+		currentTitle = FString::FromInt(notificationIndex);
+		manager.DispatchNotification(MakeNotification(feed, currentTitle));
+
+		int32 numSubscribed = 0;
+		for (bool bSubscribed : subscribed)
+		{
+			numSubscribed += bSubscribed ? 1 : 0;
+		}
+		FNotificationBackboneNotificationFeed* pfeed = manager.GetNotificationFeed(feed);
+		numMismatched += pfeed && (int32)pfeed->GetNumListeners() == numSubscribed ? 0 : 1;
+	}
+
+	for (const TSharedRef<FListener>& listener : listeners)
+	{
+		manager.UnregisterFromNotifications(listener, feed);
+		listener->onNotification = nullptr;
+	}
+
+	TestEqual(TEXT("Notifications to listeners that were not subscribed"), numUnexpected, 0);
+	TestEqual(TEXT("Notifications a listener got twice"), numDuplicated, 0);
+	TestEqual(TEXT("Dispatches after which the feed had other listeners than subscribed"), numMismatched, 0);
+	return true;
+}
+
+// Subscribing again replaces the options of the listener, also while the feed dispatches.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackboneListenerResubscribeTest, "NotificationBackbone.Listeners.ResubscribeReplacesOptions", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackboneListenerResubscribeTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed scopedFeed(FName(TEXT("NotificationBackboneTest.ListenerResubscribe")));
+	const FName feed = scopedFeed.feed;
+
+	auto dispatch = [&manager, &feed](const TCHAR* title, const FName& routingKey, ENotificationBackbonePriority priority)
+	{
+		FNotificationBackboneNotification notification = MakeNotification(feed, title);
+		notification.routingKey = routingKey;
+		notification.priority = priority;
+		manager.DispatchNotification(notification);
+	};
+
+	const FName red(TEXT("Red"));
+	const FName blue(TEXT("Blue"));
+	FNotificationBackboneListenerOptions redOptions;
+	redOptions.filterKey = red;
+	FNotificationBackboneListenerOptions highOptions;
+	highOptions.minPriority = ENotificationBackbonePriority::High;
+
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	manager.RegisterForNotifications(listener, feed, redOptions);
+	dispatch(TEXT("BlueWhileRed"), blue, ENotificationBackbonePriority::Normal);
+	manager.RegisterForNotifications(listener, feed);
+	dispatch(TEXT("BlueWithoutFilter"), blue, ENotificationBackbonePriority::Normal);
+	manager.RegisterForNotifications(listener, feed, highOptions);
+	dispatch(TEXT("NormalWhileHigh"), NAME_None, ENotificationBackbonePriority::Normal);
+	dispatch(TEXT("HighWhileHigh"), NAME_None, ENotificationBackbonePriority::High);
+
+	TArray<FString> expectedTitles;
+	expectedTitles.Add(TEXT("BlueWithoutFilter"));
+	expectedTitles.Add(TEXT("HighWhileHigh"));
+	TestTrue(TEXT("Notifications after subscribing again"), listener->titles == expectedTitles);
+
+	// The other listener moves itself into the bucket of a filter key from within its callback.
+	TSharedRef<FListener> other = MakeShareable(new FListener());
+	manager.RegisterForNotifications(other, feed);
+	other->onNotification = [&manager, &other, &feed, &redOptions](const FNotificationBackboneNotification& notification)
+	{
+		manager.RegisterForNotifications(other, feed, redOptions);
+	};
+	dispatch(TEXT("High"), NAME_None, ENotificationBackbonePriority::High);
+	other->onNotification = nullptr;
+	dispatch(TEXT("Blue"), blue, ENotificationBackbonePriority::High);
+	dispatch(TEXT("Red"), red, ENotificationBackbonePriority::High);
+
+	expectedTitles.Reset();
+	expectedTitles.Add(TEXT("High"));
+	expectedTitles.Add(TEXT("Red"));
+	TestTrue(TEXT("Notifications after subscribing again during a dispatch"), other->titles == expectedTitles);
+	FNotificationBackboneNotificationFeed* pfeed = manager.GetNotificationFeed(feed);
+	TestTrue(TEXT("Feed still has both listeners"), pfeed && pfeed->GetNumListeners() == 2);
+
+	manager.UnregisterFromNotifications(listener, feed);
+	manager.UnregisterFromNotifications(other, feed);
+	return true;
+}
+
+#endif
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NotificationBackboneTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace NotificationBackboneTest;
+
+// A listener registered for overlapping patterns stays on the feeds the pattern it keeps matches.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackbonePatternOverlapTest, "NotificationBackbone.Patterns.OverlappingUnregister", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackbonePatternOverlapTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed child(FName(TEXT("NotificationBackboneTest.Pattern.Child")));
+	FScopedFeed grandchild(FName(TEXT("NotificationBackboneTest.Pattern.Child.Grandchild")));
+	const FName anyChild(TEXT("NotificationBackboneTest.Pattern.*"));
+	const FName anyDescendant(TEXT("NotificationBackboneTest.Pattern.**"));
+
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	manager.RegisterForNotifications(listener, anyChild);
+	manager.RegisterForNotifications(listener, anyDescendant);
+
+	manager.DispatchNotification(MakeNotification(child.feed, TEXT("Both")));
+	manager.UnregisterFromNotifications(listener, anyDescendant);
+	manager.DispatchNotification(MakeNotification(child.feed, TEXT("ChildAfterDeep")));
+	manager.DispatchNotification(MakeNotification(grandchild.feed, TEXT("GrandchildAfterDeep")));
+	manager.UnregisterFromNotifications(listener, anyChild);
+	manager.DispatchNotification(MakeNotification(child.feed, TEXT("ChildAfterAll")));
+
+	TArray<FString> expectedTitles;
+	expectedTitles.Add(TEXT("Both"));
+	expectedTitles.Add(TEXT("ChildAfterDeep"));
+	TestTrue(TEXT("Notifications while the patterns come and go"), listener->titles == expectedTitles);
+	return true;
+}
+
+// Handles of patterns register for the pattern instead of creating a feed named like it.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNotificationBackbonePatternHandleTest, "NotificationBackbone.Patterns.HandleRegistration", NOTIFICATIONBACKBONE_TEST_FLAGS)
+
+bool FNotificationBackbonePatternHandleTest::RunTest(const FString& parameters)
+{
+	FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+	FScopedFeed child(FName(TEXT("NotificationBackboneTest.PatternHandle.Child")));
+	const FName pattern(TEXT("NotificationBackboneTest.PatternHandle.*"));
+
+	TSharedRef<FListener> listener = MakeShareable(new FListener());
+	FNotificationFeedHandle handle = manager.ResolveNotificationFeedHandle(pattern);
+	manager.RegisterForNotifications(listener, handle);
+
+	TestFalse(TEXT("Feed named like the pattern"), manager.GetDoesNotificationFeedExist(pattern));
+	manager.DispatchNotification(MakeNotification(child.feed, TEXT("Child")));
+	TestEqual(TEXT("Notifications of a matching feed"), listener->titles.Num(), 1);
+
+	manager.UnregisterFromNotifications(listener, pattern);
+	return true;
+}
+
+#endif
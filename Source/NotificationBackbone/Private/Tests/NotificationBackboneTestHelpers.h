@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "NotificationBackboneManager.h"
+#include "NotificationBackboneSettings.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Automation tests run against the real manager, on feeds of their own ("NotificationBackboneTest.*").
+#define NOTIFICATIONBACKBONE_TEST_FLAGS (EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace NotificationBackboneTest
+{
+	// Notes down the titles of the notifications it gets, in the order it got them. Then calls onNotification, if set.
+	class FListener : public INotificationBackboneListenerRaw
+	{
+	public:
+		virtual void OnNotification(const FNotificationBackboneNotification& notification) override
+		{
+			titles.Add(notification.GetTitle().ToString());
+			if (onNotification)
+			{
+				onNotification(notification);
+			}
+		}
+
+		virtual FName GetNotificationBackboneListenerName() override
+		{
+			return FName("NotificationBackboneTest");
+		}
+
+		TArray<FString> titles;
+		TFunction<void(const FNotificationBackboneNotification&)> onNotification;
+	};
+
+	inline FNotificationBackboneNotification MakeNotification(const FName& feed, const FString& title)
+	{
+		FNotificationBackboneNotification notification = FNotificationBackboneNotification();
+		notification.feed = feed;
+		notification.title = FText::FromString(title);
+		return notification;
+	}
+
+	// Gives the feed the default settings, whatever the project set up, and lifts the global budget while the test runs.
+	// Drops the notifications, overrides and stats of the feed afterwards. The empty feed goes idle and gets evicted as usual.
+	class FScopedFeed
+	{
+	public:
+		explicit FScopedFeed(const FName& in_feed, TFunction<void(FNotificationBackboneFeedSettings&)> modify = nullptr)
+			: feed(in_feed)
+		{
+			UNotificationBackboneSettings* backboneSettings = GetMutableDefault<UNotificationBackboneSettings>();
+			maxDispatchesPerFrame = backboneSettings->maxDispatchesPerFrame;
+			maxDispatchMicrosecondsPerFrame = backboneSettings->maxDispatchMicrosecondsPerFrame;
+			backboneSettings->maxDispatchesPerFrame = 0;
+			backboneSettings->maxDispatchMicrosecondsPerFrame = 0.f;
+
+			FNotificationBackboneManager::Get().OverrideFeedSettings(feed, [this, &modify](FNotificationBackboneFeedSettings& settings)
+			{
+				settings = FNotificationBackboneFeedSettings();
+				settings.feed = feed;
+				if (modify)
+				{
+					modify(settings);
+				}
+			});
+		}
+
+		~FScopedFeed()
+		{
+			FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+			manager.ClearNotificationFeedNotifications(feed);
+			manager.ClearFeedSettingsOverrides(feed);
+			manager.ResetFeedStats(feed);
+
+			UNotificationBackboneSettings* backboneSettings = GetMutableDefault<UNotificationBackboneSettings>();
+			backboneSettings->maxDispatchesPerFrame = maxDispatchesPerFrame;
+			backboneSettings->maxDispatchMicrosecondsPerFrame = maxDispatchMicrosecondsPerFrame;
+		}
+
+		const FName feed;
+
+	private:
+		int32 maxDispatchesPerFrame;
+		float maxDispatchMicrosecondsPerFrame;
+	};
+}
+
+#endif
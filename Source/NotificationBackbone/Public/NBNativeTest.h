@@ -24,7 +24,7 @@ public:
 #pragma region INotificationBackboneListener
 	virtual void OnNotification(const FNotificationBackboneNotification& notification) override
 	{
-		MF_LOG(Warning, false, "DEBUG: Received notification: %s \t %s \t %s", *notification.feed.ToString(), *notification.title.ToString(), *notification.message.ToString());
+		MF_LOG(Warning, false, "DEBUG: Received notification: %s \t %s \t %s", *notification.feed.ToString(), *notification.GetTitle().ToString(), *notification.GetMessage().ToString());
 	}
 
 	virtual FName GetNotificationBackboneListenerName() override
@@ -5,6 +5,74 @@
 #include "CoreMinimal.h"
 #include "NotificationBackboneBPTypes.generated.h"
 
+class FJsonObject;
+class FNotificationBackboneJsonPayload;
+class FNotificationBackboneDeferredText;
+
+// Feeds dispatch notifications of higher priority first.
+UENUM(BlueprintType)
+enum class ENotificationBackbonePriority : uint8
+{
+	Low,
+	Normal,
+	High,
+	Critical
+};
+
+// What a full feed does with an incoming notification.
+UENUM(BlueprintType)
+enum class ENotificationBackboneOverflowPolicy : uint8
+{
+	// The incoming notification gets dropped.
+	DropNewest,
+	// The oldest queued notification of the lowest priority gets dropped to make room.
+	DropOldest,
+	// The incoming notification gets refused. For producers that want to react on a full feed, e.g. by trying again later.
+	Reject
+};
+
+// What a feed does with an incoming notification whose coalescing key is already queued.
+UENUM(BlueprintType)
+enum class ENotificationBackboneCoalesceMode : uint8
+{
+	// Every notification gets queued.
+	None,
+	// The queued notification gets replaced by the incoming one, but keeps its place in the queue.
+	ReplaceLatest,
+	// The merge function of the feed merges the incoming notification into the queued one.
+	// Falls back to ReplaceLatest when the feed has no merge function.
+	Merge
+};
+
+// What a feed does with a notification whose soft icon is not loaded yet when it is its turn.
+UENUM(BlueprintType)
+enum class ENotificationBackboneIconLoadPolicy : uint8
+{
+	// The notification waits until the icon is loaded. So do the notifications behind it with the same priority.
+	HoldBack,
+	// The notification gets dispatched with the placeholder icon of the settings.
+	Placeholder
+};
+
+UENUM(BlueprintType)
+enum class ENotificationBackboneDispatchResult : uint8
+{
+	// The notification got dispatched or waits in the feed.
+	Queued,
+	// The notification waits in the feed, the oldest one of the feed got dropped to make room.
+	QueuedDroppedOldest,
+	// Nobody listens and the feed does not cache notifications.
+	DroppedNoListeners,
+	// The feed is full and dropped the notification.
+	DroppedOverflow,
+	// The feed is full and refused the notification.
+	Rejected,
+	// Dispatched from another thread than the game thread. The notification waits to be picked up by the game thread.
+	Deferred,
+	// Got merged into a queued notification with the same coalescing key.
+	Coalesced
+};
+
 USTRUCT(BlueprintType)
 struct FNotificationBackboneMessageData
 {
@@ -15,7 +83,21 @@ struct FNotificationBackboneMessageData
 	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
 		FText message;
 	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
-		UTexture2D* icon;
+		UTexture2D* icon = nullptr;
+
+	// Use this instead of icon to not load the texture yourself. The feed loads it asynchronously when the notification comes in
+	// and keeps it loaded until the notification got dispatched. Listeners find it in icon.
+	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
+		TSoftObjectPtr<UTexture2D> softIcon;
+
+	// Returns icon, or the soft icon if it is loaded.
+	UTexture2D* GetIcon() const;
+
+	// Whether there is a soft icon to resolve into icon.
+	bool HasUnresolvedIcon() const
+	{
+		return icon == nullptr && !softIcon.IsNull();
+	}
 };
 
 USTRUCT(BlueprintType)
@@ -26,10 +108,145 @@ struct FNotificationBackboneNotification : public FNotificationBackboneMessageDa
 	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
 		FName feed;
 
+	// Notifications with the same key get merged while they wait in the feed (see coalesceMode of the feed settings).
+	// None to never merge.
+	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
+		FName coalescingKey;
+
+	// Only listeners without a filter key and listeners whose filter key matches get the notification,
+	// e.g. the id of the player the notification is for. None to send it to all listeners.
+	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
+		FName routingKey;
+
+	// Notifications of higher priority get dispatched first. E.g. "disconnected" does not have to wait behind queued item pickups.
+	UPROPERTY(BlueprintReadWrite, VisibleAnywhere)
+		ENotificationBackbonePriority priority = ENotificationBackbonePriority::Normal;
+
+	// Number of notifications merged into this one, e.g. for "item picked up x N".
+	// DO NOT SET IT, WILL GET OVERWRITTEN BY THE FEED
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 coalescedCount = 1;
+
 	// You can use this to dynamically set the lifetime of the notification widget.
 	// DO NOT SET IT, WILL GET OVERWRITTEN BY THE FEED
+	// C++ listeners get it with the dispatch context instead (see FNotificationBackboneDispatchContext).
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float feedDispatchDelay = 0.f;
+
+	// Structured data, shared by all copies of the notification and parsed at most once (see FNotificationBackboneJsonPayload).
+	// Set it with SetJson.
+	TSharedPtr<const FNotificationBackboneJsonPayload, ESPMode::ThreadSafe> json;
+
+	// Attaches a JSON string. It gets parsed when the first listener asks for it.
+	void SetJson(const FString& jsonString);
+	// Attaches an object as is, without serializing it.
+	void SetJson(const TSharedRef<FJsonObject>& jsonObject);
+	// Returns the attached JSON object, nullptr when there is none or it is no valid JSON object.
+	TSharedPtr<FJsonObject> GetJson() const;
+
+	// Title and message formatted the first time they get read (see FNotificationBackboneDeferredText).
+	// Set them with SetDeferredTitle and SetDeferredMessage, C++ listeners read them with GetTitle and GetMessage.
+	// Blueprint listeners get them formatted into title and message.
+	TSharedPtr<const FNotificationBackboneDeferredText, ESPMode::ThreadSafe> deferredTitle;
+	TSharedPtr<const FNotificationBackboneDeferredText, ESPMode::ThreadSafe> deferredMessage;
+
+	void SetDeferredTitle(const FTextFormat& format, FFormatNamedArguments arguments);
+	void SetDeferredTitle(const FTextFormat& format, FFormatOrderedArguments arguments);
+	void SetDeferredMessage(const FTextFormat& format, FFormatNamedArguments arguments);
+	void SetDeferredMessage(const FTextFormat& format, FFormatOrderedArguments arguments);
+
+	bool HasDeferredText() const
+	{
+		return deferredTitle.IsValid() || deferredMessage.IsValid();
+	}
+
+	// Formats the title on first use when it is deferred.
+	const FText& GetTitle() const;
+	// Formats the message on first use when it is deferred.
+	const FText& GetMessage() const;
+
+	// Writes the deferred texts into title and message.
+	void ResolveDeferredText();
+};
+
+// How a listener subscribes to a feed. The feed filters, so listeners only get called for notifications they want.
+// Subscribing again to the same feed replaces the options.
+USTRUCT(BlueprintType)
+struct FNotificationBackboneListenerOptions
+{
+	GENERATED_BODY();
+
+	// Only notifications with this routing key or without routing key. None to get all notifications.
+	// Feeds look listeners up by key, listeners with other keys cost nothing.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		FName filterKey;
+
+	// Only notifications of at least this priority.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		ENotificationBackbonePriority minPriority = ENotificationBackbonePriority::Low;
+
+	// C++ only. Only notifications the predicate returns true for. Keep it cheap, it runs for every notification.
+	TFunction<bool(const FNotificationBackboneNotification&)> predicate;
+
+	// C++ only, raw listeners only. The listener is thread safe and gets called on a task graph worker, not on the game thread.
+	// It gets the notifications of a feed one after the other, in order. It must not touch UObjects, besides reading the icon.
+	// JSON only through json->ParseObject or json->GetString, GetJson shares an object that is not thread safe.
+	// The predicate still runs on the game thread. See FNotificationBackboneNotificationFeed::GetAsyncListenerCompletion.
+	bool bAsync = false;
+};
+
+/**
+ * A notification that got sent off. Immutable and shared by the feed queues and all listeners, so the payload
+ * gets built once and never copied. Safe to build on any thread.
+ */
+typedef TSharedRef<const FNotificationBackboneNotification, ESPMode::ThreadSafe> FNotificationBackboneNotificationRef;
+typedef TSharedPtr<const FNotificationBackboneNotification, ESPMode::ThreadSafe> FNotificationBackboneNotificationPtr;
+
+inline FNotificationBackboneNotificationRef MakeNotificationBackboneNotification(const FNotificationBackboneNotification& notification)
+{
+	return MakeShared<FNotificationBackboneNotification, ESPMode::ThreadSafe>(notification);
+}
+
+inline FNotificationBackboneNotificationRef MakeNotificationBackboneNotification(FNotificationBackboneNotification&& notification)
+{
+	return MakeShared<FNotificationBackboneNotification, ESPMode::ThreadSafe>(MoveTemp(notification));
+}
+
+// What the feed knows about the notification it dispatches. Comes next to the notification, which stays untouched.
+struct FNotificationBackboneDispatchContext
+{
+	// Feed that dispatches the notification.
+	FName feed;
+	// Delay between the dispatches of the feed, e.g. to set the lifetime of a notification widget.
+	float feedDispatchDelay = 0.f;
+	// Notifications still waiting in the feed.
+	uint32 numQueuedNotifications = 0;
+	// The icon of the notification, the soft icon resolved or the placeholder.
+	UTexture2D* icon = nullptr;
+};
+
+/**
+ * Refers to a notification feed without looking it up by name.
+ * Resolve it once and reuse it. When the feed got destroyed in the meantime, the handle falls back to the feed name.
+ */
+USTRUCT(BlueprintType)
+struct FNotificationFeedHandle
+{
+	GENERATED_BODY();
+
+	FNotificationFeedHandle()
+	{
+		index = INDEX_NONE;
+		generation = 0;
+	}
+
+	// Name of the feed this handle refers to
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
-		float feedDispatchDelay;
+		FName feed;
+
+	// Slot of the feed in the manager and the generation of that slot. Only valid for the current session.
+	int32 index;
+	uint32 generation;
 };
 
 USTRUCT(BlueprintType)
@@ -43,7 +260,7 @@ struct FNotificationBackboneFeedSettings
 		bClearNotificationsNoListeners = false;
 	}
 
-	// Name of the feed this settings belong to
+	// Name of the feed this settings belong to. Can be a pattern like "Combat.**", feeds without own settings use the first matching pattern.
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		FName feed;
 
@@ -51,6 +268,18 @@ struct FNotificationBackboneFeedSettings
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		float dispatchDelay = 0.f;
 
+	// Number of notifications dispatched each time the dispatch delay passed.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "1"))
+		int32 dispatchBatchSize = 1;
+
+	// Max number of notifications the feed dispatches per frame. The rest waits for the next frame. 0 for no limit.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+		int32 maxDispatchesPerFrame = 0;
+
+	// Max time in microseconds the feed spends dispatching per frame. The rest waits for the next frame. 0 for no limit.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+		float maxDispatchMicrosecondsPerFrame = 0.f;
+
 	// Check if we shall cache notifications in case there is no one listener
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		uint8 bCacheNotificationsNoListeners : 1;
@@ -59,4 +288,103 @@ struct FNotificationBackboneFeedSettings
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 		uint8 bClearNotificationsNoListeners : 1;
 
-};
\ No newline at end of file
+	// Max number of notifications waiting in the feed. The memory for them gets allocated up front. 0 for no limit.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+		int32 maxQueuedNotifications = 0;
+
+	// What to do with incoming notifications when maxQueuedNotifications is reached.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		ENotificationBackboneOverflowPolicy overflowPolicy = ENotificationBackboneOverflowPolicy::DropOldest;
+
+	// Lower priority notifications get dispatched once after this many dispatches of higher priority notifications
+	// passed them, so they do not starve. 0 to always dispatch by priority.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+		int32 priorityAgingThreshold = 0;
+
+	// What to do with incoming notifications whose coalescing key is already queued.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		ENotificationBackboneCoalesceMode coalesceMode = ENotificationBackboneCoalesceMode::None;
+
+	// What to do when the soft icon of the next notification is not loaded yet.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+		ENotificationBackboneIconLoadPolicy iconLoadPolicy = ENotificationBackboneIconLoadPolicy::HoldBack;
+
+};
+
+// What a feed did since it got created or its stats got reset. Counts beyond the range of int32 stay at its max.
+USTRUCT(BlueprintType)
+struct FNotificationBackboneFeedStats
+{
+	GENERATED_BODY();
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		FName feed;
+
+	// Notifications that went into the queue.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numEnqueued = 0;
+
+	// Notifications merged into a queued one.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numCoalesced = 0;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numDispatched = 0;
+
+	// Notifications dropped because nobody listened and the feed does not cache.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numDroppedNoListeners = 0;
+
+	// Notifications dropped or rejected because the feed was full.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numDroppedOverflow = 0;
+
+	// Queued notifications thrown away by clearing the feed.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numCleared = 0;
+
+	// Notifications waiting in the feed right now.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 numQueuedNotifications = 0;
+
+	// Most notifications that waited in the feed at once.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		int32 maxQueuedNotifications = 0;
+
+	// Time from the notification going into the queue until it got dispatched.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float averageLatencyMilliseconds = 0.f;
+
+	// Percentiles are estimated from the histogram, they are the upper bound of the bucket.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float latencyP50Milliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float latencyP90Milliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float latencyP99Milliseconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float maxLatencyMilliseconds = 0.f;
+
+	// Bucket i counts the dispatches with a latency below 2^i microseconds, the last bucket the rest.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		TArray<int32> latencyHistogram;
+
+	// Time spent in the callbacks of the listeners.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float listenerMilliseconds = 0.f;
+
+	// Listener with the slowest single callback.
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		FName slowestListener;
+
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere)
+		float slowestListenerMilliseconds = 0.f;
+};
+
+// Merges the incoming notification into the queued one, e.g. summing up a damage number.
+DECLARE_DELEGATE_TwoParams(FOnNotificationBackboneMerge, FNotificationBackboneNotification& /*queued*/, const FNotificationBackboneNotification& /*incoming*/);
+// Returns the merge result of the queued and the incoming notification.
+DECLARE_DYNAMIC_DELEGATE_RetVal_TwoParams(FNotificationBackboneNotification, FNotificationBackboneMergeDynamicDelegate, const FNotificationBackboneNotification&, queued, const FNotificationBackboneNotification&, incoming);
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "NotificationBackboneListener.h"
+#include "NotificationBackboneBenchmark.generated.h"
+
+// One scenario of the benchmark. Times are per sample, e.g. per dispatch.
+struct FNotificationBackboneBenchmarkResult
+{
+	FString scenario;
+	int32 numListeners = 0;
+	int32 numSamples = 0;
+	// Time of all samples together.
+	double totalMilliseconds = 0.0;
+	double samplesPerSecond = 0.0;
+	double p50Microseconds = 0.0;
+	double p90Microseconds = 0.0;
+	double p99Microseconds = 0.0;
+	double maxMicroseconds = 0.0;
+	// Memory the process grew by per queued notification. 0 when not measured or the allocator had the memory already.
+	double bytesPerItem = 0.0;
+};
+
+/**
+ * Measures dispatch throughput and latency of the backbone, so plugin versions can be compared before they go to production.
+ * Runs on the game thread against the real manager through its public API, on feeds of its own ("NotificationBackboneBenchmark.*").
+ * Scenarios that need the manager to tick (feed churn, delayed feeds) spread over frames, so Tick has to be called once per frame
+ * until it returns true. The global budget of the settings is lifted meanwhile. Run it outside of gameplay, e.g. headless with the
+ * automation test Benchmarks.NotificationBackbone or in a running game with the console command NotificationBackbone.Benchmark.
+ */
+class NOTIFICATIONBACKBONE_API FNotificationBackboneBenchmark
+{
+public:
+	struct FOptions
+	{
+		// Dispatches per dispatch scenario, feeds per churn scenario, notifications in the delayed feed.
+		int32 iterations = 10000;
+		// Notifications waiting in the cached feed.
+		int32 numCachedNotifications = 100000;
+		// Feeds the churn scenario creates per frame. They get destroyed when the manager ticks.
+		int32 numChurnFeedsPerFrame = 100;
+		// Where the CSV and JSON files go. Saved/Profiling/NotificationBackbone when empty.
+		FString outputDirectory;
+	};
+
+	FNotificationBackboneBenchmark(const FOptions& in_options) : options(in_options) {}
+	~FNotificationBackboneBenchmark();
+
+	// Runs the next step. Returns true once all scenarios ran. Game thread only.
+	bool Tick();
+
+	// Writes the results as <Directory>/NotificationBackboneBenchmark-<Time>.csv and .json. Returns false when a file could not be written.
+	bool WriteResults(FString& outBasePath) const;
+
+	const TArray<FNotificationBackboneBenchmarkResult>& GetResults() const
+	{
+		return results;
+	}
+
+	// Reads the options from the command line, e.g. -NotificationBackboneBenchmarkIterations=1000. See README.
+	static FOptions ParseOptions(const TCHAR* commandLine);
+
+private:
+	enum class EStep : uint8
+	{
+		Start,
+		Dispatch,
+		FeedChurn,
+		DelayedFeed,
+		CachedFeed,
+		Done
+	};
+
+	// Every dispatch into an immediate feed with that many raw and UObject listeners.
+	void RunDispatch(const TCHAR* scenario, int32 numRawListeners, int32 numObjectListeners);
+	// Feeds getting created, subscribed to and left, some per frame. The manager destroys and recycles them when it ticks.
+	// Returns true once all feeds got churned.
+	bool TickFeedChurn();
+	// From the dispatch into a delayed feed until the listener has it, while the manager ticks.
+	void StartDelayedFeed();
+	bool TickDelayedFeed();
+	// Enqueueing into a feed that caches without listeners and draining it once a listener comes.
+	void RunCachedFeed();
+
+	// Lifts the global budget and makes empty feeds go away the next time the manager ticks. Finish puts the settings back.
+	void Start();
+	void Finish();
+
+	// Sorts the samples and adds the result.
+	FNotificationBackboneBenchmarkResult& AddResult(const TCHAR* scenario, int32 numListeners, TArray<uint64>& sampleCycles);
+
+	// Drops the notifications, overrides and stats of the feed. The empty feed gets destroyed the next time the manager ticks.
+	void CleanUpFeed(const FName& feed);
+
+	FOptions options;
+	EStep step = EStep::Start;
+	TArray<FNotificationBackboneBenchmarkResult> results;
+
+	// State of the scenario spread over frames.
+	int32 numChurnedFeeds = 0;
+	int32 numFrames = 0;
+	double startSeconds = 0.0;
+	TArray<uint64> scenarioSampleCycles;
+	TArray<uint64> dispatchCycles;
+	TSharedPtr<INotificationBackboneListenerRaw> listener;
+
+	// Settings the benchmark changes while it runs.
+	int32 maxDispatchesPerFrame = 0;
+	float maxDispatchMicrosecondsPerFrame = 0.f;
+	float idleFeedGracePeriod = 0.f;
+};
+
+// Counts what it gets. For the UObject listener scenarios of the benchmark.
+UCLASS(Transient)
+class NOTIFICATIONBACKBONE_API UNotificationBackboneBenchmarkListener : public UObject, public INotificationBackboneListener
+{
+	GENERATED_BODY()
+public:
+	virtual bool OnNotification_Implementation(const FNotificationBackboneNotification& notification) override
+	{
+		++numNotifications;
+		return true;
+	}
+
+	int32 numNotifications = 0;
+};
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "NotificationBackboneBPTypes.h"
+
+class IFileHandle;
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Streams notifications into a compact binary log, to replay production traffic later (see FNotificationBackboneReplay).
+ *
+ * Format: magic and version, then one record per notification. Times are microseconds since the record before, names go
+ * into a table the first time they show up and are referred to by index from then on. Numbers are packed.
+ *
+ * Records go into a small buffer on the game thread. Full buffers get written to disk by a thread of our own and come back to be reused,
+ * so the game thread neither waits for the disk nor allocates once the buffers are there. Without the thread, e.g. on platforms
+ * without threads, the game thread writes the buffers itself.
+ */
+class NOTIFICATIONBACKBONE_API FNotificationBackboneCapture : public FRunnable
+{
+public:
+	static const uint32 Magic = 0x5043424E; // "NBCP"
+	static const uint32 Version = 1;
+
+	// Returns nullptr when the file could not be created.
+	static TUniquePtr<FNotificationBackboneCapture> Create(const FString& path);
+
+	// Writes what is left and closes the file.
+	virtual ~FNotificationBackboneCapture();
+
+	// Game thread only.
+	void Record(const FNotificationBackboneNotification& notification);
+
+	const FString& GetPath() const
+	{
+		return path;
+	}
+
+	uint64 GetNumRecorded() const
+	{
+		return numRecorded;
+	}
+
+	// FRunnable, the writer thread.
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	FNotificationBackboneCapture(const FString& in_path, IFileHandle* in_file);
+
+	void SerializeName(FArchive& archive, const FName& name);
+	// Hands the buffer over to the writer thread and takes an empty one. Writes it right away when there is no writer thread.
+	void FlushBuffer();
+	// Writer thread only.
+	void WriteFullBuffers();
+	// Writer thread, or the game thread when there is no writer thread.
+	void WriteBuffer(const TArray<uint8>& fullBuffer);
+
+	// Buffers get written once they are this full.
+	static const int32 BufferSize = 64 * 1024;
+
+	FString path;
+	IFileHandle* file;
+
+	// Game thread.
+	TArray<uint8> buffer;
+	TMap<FName, uint32> nameIndices;
+	double lastRecordSeconds;
+	uint64 numRecorded = 0;
+
+	// Game thread -> writer thread and back.
+	TQueue<TArray<uint8>, EQueueMode::Spsc> fullBuffers;
+	TQueue<TArray<uint8>, EQueueMode::Spsc> emptyBuffers;
+	FEvent* wakeEvent = nullptr;
+	FThreadSafeBool bStopping;
+	// Null when the thread could not be created.
+	FRunnableThread* thread = nullptr;
+};
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Text that gets formatted the first time somebody reads it. The result is kept, the arguments get released.
+ * Shared by all copies of the notification, so it gets formatted at most once. Dropped notifications never get formatted.
+ */
+class NOTIFICATIONBACKBONE_API FNotificationBackboneDeferredText
+{
+public:
+	FNotificationBackboneDeferredText(const FTextFormat& in_format, FFormatNamedArguments&& in_arguments);
+	FNotificationBackboneDeferredText(const FTextFormat& in_format, FFormatOrderedArguments&& in_arguments);
+
+	const FText& Get() const;
+
+private:
+	FTextFormat format;
+	mutable FFormatNamedArguments namedArguments;
+	mutable FFormatOrderedArguments orderedArguments;
+	bool bNamedArguments;
+
+	mutable FCriticalSection lock;
+	mutable FText text;
+	mutable bool bFormatted = false;
+};
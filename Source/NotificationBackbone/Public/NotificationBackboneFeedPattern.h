@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Feed names can be hierarchical, segments separated by dots, e.g. "Combat.Damage.Fire".
+ * Listeners and feed settings can use patterns instead of feed names:
+ *	"Combat.*"			every feed exactly one level below Combat, e.g. "Combat.Damage"
+ *	"Combat.**"			every feed below Combat, e.g. "Combat.Damage" and "Combat.Damage.Fire"
+ *	"Combat.*.Fire"		"*" works for any segment, "**" only as the last one
+ * Like feed names, patterns are case insensitive.
+ */
+struct NOTIFICATIONBACKBONE_API FNotificationBackboneFeedPattern
+{
+	// "*", exactly one segment
+	static const FName AnySegment;
+	// "**", one or more segments. Only as the last segment.
+	static const FName AnySegments;
+
+	static bool IsPattern(const FName& name);
+
+	static void Split(const FName& name, TArray<FName>& outSegments);
+
+	// Returns false for patterns with "**" anywhere else than at the end.
+	static bool IsValid(const TArray<FName>& pattern);
+
+	static bool Matches(const TArray<FName>& pattern, const TArray<FName>& feed);
+};
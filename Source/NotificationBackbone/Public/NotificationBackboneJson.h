@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Dom/JsonObject.h"
+
+/**
+ * JSON attached to a notification. Shared by all copies of the notification, thus by all listeners of a dispatch.
+ * A string gets parsed at most once, the first time somebody asks for the object. An attached object never gets serialized,
+ * unless somebody asks for the string.
+ * Treat the object as read only, every listener sees the same one.
+ * The shared object and its values are not thread safe. Off the game thread, e.g. in async listeners, use GetString or ParseObject.
+ */
+class NOTIFICATIONBACKBONE_API FNotificationBackboneJsonPayload
+{
+public:
+	explicit FNotificationBackboneJsonPayload(const FString& in_jsonString);
+	explicit FNotificationBackboneJsonPayload(FString&& in_jsonString);
+	explicit FNotificationBackboneJsonPayload(const TSharedRef<FJsonObject>& in_jsonObject);
+
+	// Returns the parsed object, nullptr when the string is no valid JSON object.
+	TSharedPtr<FJsonObject> GetObject() const;
+
+	// Returns the JSON as a string.
+	FString GetString() const;
+
+	// Returns a new object parsed from the string, owned by the caller. Safe on any thread once the string exists,
+	// feeds make sure of that before they call async listeners. nullptr when the string is no valid JSON object.
+	TSharedPtr<FJsonObject> ParseObject() const;
+
+	// Returns the value at the path, e.g. "damage.amount". Each part but the last must be an object. nullptr when there is no such value.
+	TSharedPtr<FJsonValue> FindField(const FString& path) const;
+
+private:
+	mutable FCriticalSection lock;
+	mutable FString jsonString;
+	mutable TSharedPtr<FJsonObject> jsonObject;
+	mutable bool bParsed;
+	mutable bool bHasString;
+};
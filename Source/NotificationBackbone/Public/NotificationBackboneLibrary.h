@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "NotificationBackboneManager.h"
+#include "NotificationBackboneJson.h"
 #include "NotificationBackboneDeclarations.h"
 #include "NotificationBackboneLibrary.generated.h"
 
@@ -25,16 +26,45 @@ public:
 		FNotificationBackboneManager::Get().RegisterForNotificationsUObject(object, feed);
 	}
 
+	// The feed only passes the notifications the options let through, e.g. the ones for a particular player.
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
+		static void RegisterForNotificationWithOptions(TScriptInterface<INotificationBackboneListener> object, FName feed, const FNotificationBackboneListenerOptions& options)
+	{
+		FNotificationBackboneManager::Get().RegisterForNotificationsUObject(object, feed, options);
+	}
+
 	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
 		static void UnregisterFromNotification(TScriptInterface<INotificationBackboneListener> object, FName feed)
 	{
 		FNotificationBackboneManager::Get().UnregisterFromNotificationsUObject(object, feed);
 	}
 
+	// Returns what the feed did with the notification.
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
+		static ENotificationBackboneDispatchResult DispatchNotification(const FNotificationBackboneNotification& notification)
+	{
+		return FNotificationBackboneManager::Get().DispatchNotification(notification);
+	}
+
+	// Resolve the handle once and use it with the "By Handle" functions to skip the feed lookup by name.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static FNotificationFeedHandle ResolveFeedHandle(const FName& feed)
+	{
+		return FNotificationBackboneManager::Get().ResolveNotificationFeedHandle(feed);
+	}
+
+	// The handle decides the feed. A stale handle gets refreshed.
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
+		static ENotificationBackboneDispatchResult DispatchNotificationByHandle(UPARAM(ref) FNotificationFeedHandle& feedHandle, const FNotificationBackboneNotification& notification)
+	{
+		return FNotificationBackboneManager::Get().DispatchNotification(feedHandle, notification);
+	}
+
+	// A stale handle gets refreshed.
 	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
-		static void DispatchNotification(const FNotificationBackboneNotification& notification)
+		static void RegisterForNotificationByHandle(TScriptInterface<INotificationBackboneListener> object, UPARAM(ref) FNotificationFeedHandle& feedHandle)
 	{
-		FNotificationBackboneManager::Get().DispatchNotification(notification);
+		FNotificationBackboneManager::Get().RegisterForNotificationsUObject(object, feedHandle);
 	}
 
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
@@ -54,10 +84,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
 		static bool DoesNotificationFeedHaveListeners(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			return (*pfeed)->GetDoesHaveListeners();
+			return pfeed->GetDoesHaveListeners();
 		}
 
 		return false;
@@ -67,10 +97,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
 		static bool DoesNotificationFeedHaveNotifications(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			return (*pfeed)->GetDoesHaveNotifications();
+			return pfeed->GetDoesHaveNotifications();
 		}
 
 		return false;
@@ -80,10 +110,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
 		static int32 GetNotificationFeedNumListeners(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			return (*pfeed)->GetNumListeners();
+			return pfeed->GetNumListeners();
 		}
 
 		return 0;
@@ -93,18 +123,120 @@ public:
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
 		static int32 GetNotificationFeedNumNotifications(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			return (*pfeed)->GetNumNotifications();
+			return pfeed->GetNumNotifications();
 		}
 
 		return 0;
 	}
 
+	// Returns false if there is no listener or feed does not exist
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static bool DoesNotificationFeedHaveListenersByHandle(const FNotificationFeedHandle& feedHandle)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feedHandle);
+		if (pfeed)
+		{
+			return pfeed->GetDoesHaveListeners();
+		}
+
+		return false;
+	}
+
+	// Returns false if there is no notification or feed does not exist
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static bool DoesNotificationFeedHaveNotificationsByHandle(const FNotificationFeedHandle& feedHandle)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feedHandle);
+		if (pfeed)
+		{
+			return pfeed->GetDoesHaveNotifications();
+		}
+
+		return false;
+	}
+
+	// Returns 0 if there is no listener or feed does not exist
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static int32 GetNotificationFeedNumListenersByHandle(const FNotificationFeedHandle& feedHandle)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feedHandle);
+		if (pfeed)
+		{
+			return pfeed->GetNumListeners();
+		}
+
+		return 0;
+	}
+
+	// Returns 0 if there is no notification or feed does not exist
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static int32 GetNotificationFeedNumNotificationsByHandle(const FNotificationFeedHandle& feedHandle)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feedHandle);
+		if (pfeed)
+		{
+			return pfeed->GetNumNotifications();
+		}
+
+		return 0;
+	}
+
+	// Returns the number of notifications of that priority waiting in the feed.
+	// Returns 0 if there is no notification or feed does not exist
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static int32 GetNotificationFeedNumNotificationsWithPriority(const FName& feed, ENotificationBackbonePriority priority)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		if (pfeed)
+		{
+			return pfeed->GetNumNotifications(priority);
+		}
+
+		return 0;
+	}
+
+	// Returns the number of notifications the feed lost because it was full. 0 if the feed does not exist.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
+		static int32 GetNotificationFeedNumDroppedNotifications(const FName& feed)
+	{
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		if (pfeed)
+		{
+			return (int32)FMath::Min<uint64>(pfeed->GetNumDroppedNotifications(), MAX_int32);
+		}
+
+		return 0;
+	}
+
+#pragma region Stats
+	// Returns false when the feed has no stats, e.g. it never got a notification since the stats got reset.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Stats")
+		static bool GetNotificationFeedStats(const FName& feed, FNotificationBackboneFeedStats& stats)
+	{
+		return FNotificationBackboneManager::Get().GetFeedStats(feed, stats);
+	}
+
+	// Stats of all feeds that have some, also of feeds that got destroyed in the meantime.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Stats")
+		static void GetAllNotificationFeedStats(TArray<FNotificationBackboneFeedStats>& stats)
+	{
+		FNotificationBackboneManager::Get().GetAllFeedStats(stats);
+	}
+
+	// Starts the stats of the feed over, of all feeds for None.
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone|Stats")
+		static void ResetNotificationFeedStats(const FName& feed)
+	{
+		FNotificationBackboneManager::Get().ResetFeedStats(feed);
+	}
+#pragma endregion Stats
+
 	/**
 	 * Blocks a feed from dispatching notifications.
-	 * This only holds until the feed is completely empty (no listeners, no notifications), as the feed will get destroyed.
+	 * This only holds until the feed got destroyed after being completely empty (no listeners, no notifications) for a while (see settings).
 	 * This can be useful for map changes or when you have to load, during a NPC conversation, while the player is in the inventory, ...
 	 *
 	 * Returns false if feed does not exist
@@ -112,10 +244,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
 		static bool BlockNotificationFeed(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			(*pfeed)->BlockDispatching();
+			pfeed->BlockDispatching();
 			return true;
 		}
 
@@ -128,10 +260,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
 		static bool UnblockNotificationFeed(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			(*pfeed)->ContinueDispatching();
+			pfeed->ContinueDispatching();
 			return true;
 		}
 
@@ -143,10 +275,10 @@ public:
 		static void GetNotificationFeedListenerNames(const FName& feed, TArray<FString>& listeners)
 	{
 		listeners.Empty();
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			(*pfeed)->GetListenerNames(listeners);
+			pfeed->GetListenerNames(listeners);
 		}
 	}
 
@@ -155,10 +287,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = "NotificationBackbone")
 		static bool IsNotificationFeedBlocked(const FName& feed)
 	{
-		TSharedRef<FNotificationBackboneNotificationFeed>* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
+		FNotificationBackboneNotificationFeed* pfeed = FNotificationBackboneManager::Get().GetNotificationFeed(feed);
 		if (pfeed)
 		{
-			return (*pfeed)->GetIsBlocked();
+			return pfeed->GetIsBlocked();
 		}
 
 		return false;
@@ -172,15 +304,113 @@ public:
 		return FNotificationBackboneManager::Get().ClearNotificationFeedNotifications(feed);
 	}
 
+	/**
+	 * Sets the function that merges notifications with the same coalescing key for the feed.
+	 * Only used when the coalesce mode of the feed is Merge. Pass an unbound delegate to remove it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
+		static void SetNotificationFeedMergeFunction(const FName& feed, FNotificationBackboneMergeDynamicDelegate mergeFunction)
+	{
+		FOnNotificationBackboneMerge nativeMergeFunction;
+		if (mergeFunction.IsBound())
+		{
+			nativeMergeFunction.BindLambda([mergeFunction](FNotificationBackboneNotification& queued, const FNotificationBackboneNotification& incoming)
+			{
+				// The bound object might be gone by now.
+				if (mergeFunction.IsBound())
+				{
+					queued = mergeFunction.Execute(queued, incoming);
+				}
+			});
+		}
+		FNotificationBackboneManager::Get().SetNotificationFeedMergeFunction(feed, nativeMergeFunction);
+	}
+
+#pragma region Json
+	// Attaches JSON to the notification. It gets parsed once, when the first listener reads from it.
+	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone|Json")
+		static void SetNotificationJson(UPARAM(ref) FNotificationBackboneNotification& notification, const FString& json)
+	{
+		notification.SetJson(json);
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Json")
+		static bool DoesNotificationHaveJson(const FNotificationBackboneNotification& notification)
+	{
+		return notification.json.IsValid();
+	}
+
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Json")
+		static FString GetNotificationJsonString(const FNotificationBackboneNotification& notification)
+	{
+		return notification.json.IsValid() ? notification.json->GetString() : FString();
+	}
+
+	// Path like "damage.type". Returns false when there is no such field.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Json")
+		static bool GetNotificationJsonStringField(const FNotificationBackboneNotification& notification, const FString& path, FString& value)
+	{
+		TSharedPtr<FJsonValue> field = notification.json.IsValid() ? notification.json->FindField(path) : nullptr;
+		return field.IsValid() && field->TryGetString(value);
+	}
+
+	// Path like "damage.amount". Returns false when there is no such field.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Json")
+		static bool GetNotificationJsonNumberField(const FNotificationBackboneNotification& notification, const FString& path, float& value)
+	{
+		TSharedPtr<FJsonValue> field = notification.json.IsValid() ? notification.json->FindField(path) : nullptr;
+		double number = 0.0;
+		if (field.IsValid() && field->TryGetNumber(number))
+		{
+			value = (float)number;
+			return true;
+		}
+		return false;
+	}
+
+	// Path like "damage.critical". Returns false when there is no such field.
+	UFUNCTION(BlueprintPure, Category = "NotificationBackbone|Json")
+		static bool GetNotificationJsonBoolField(const FNotificationBackboneNotification& notification, const FString& path, bool& value)
+	{
+		TSharedPtr<FJsonValue> field = notification.json.IsValid() ? notification.json->FindField(path) : nullptr;
+		return field.IsValid() && field->TryGetBool(value);
+	}
+#pragma endregion Json
+
+	/**
+	 * Dispatches the struct into the typed C++ channel of that struct type (see TNotificationChannel).
+	 * Returns false when C++ did not enable the Blueprint bridge for the struct or nobody listens.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "NotificationBackbone|Channel", meta = (CustomStructureParam = "payload"))
+		static bool DispatchChannelNotification(FName channel, const int32& payload);
+
+	DECLARE_FUNCTION(execDispatchChannelNotification)
+	{
+		P_GET_PROPERTY(UNameProperty, channel);
+
+		// Wildcard, the struct type is only known at runtime.
+		Stack.MostRecentProperty = nullptr;
+		Stack.MostRecentPropertyAddress = nullptr;
+		Stack.StepCompiledIn<UStructProperty>(nullptr);
+		UStructProperty* payloadProperty = Cast<UStructProperty>(Stack.MostRecentProperty);
+		const void* payload = Stack.MostRecentPropertyAddress;
+		P_FINISH;
+
+		bool bDispatched = false;
+		P_NATIVE_BEGIN;
+		if (payloadProperty && payload)
+		{
+			bDispatched = FNotificationBackboneManager::Get().DispatchChannelPayload(payloadProperty->Struct, channel, payload);
+		}
+		P_NATIVE_END;
+		*(bool*)RESULT_PARAM = bDispatched;
+	}
+
 	// Returns false when there are no settings for that feed.
 	UFUNCTION(BlueprintCallable, Category = "NotificationBackbone")
 		static bool GetNotificationFeedSettings(const FName& feed, FNotificationBackboneFeedSettings& settings)
 	{
-		const FNotificationBackboneFeedSettings* p_settings = UNotificationBackboneSettings::Get()->feedSettings.FindByPredicate(
-			[feed](const FNotificationBackboneFeedSettings& in_settings) -> bool
-		{
-			return in_settings.feed == feed;
-		});
+		const FNotificationBackboneFeedSettings* p_settings = UNotificationBackboneSettings::Get()->FindFeedSettings(feed);
 
 		if (p_settings)
 		{
@@ -33,6 +33,13 @@ class NOTIFICATIONBACKBONE_API INotificationBackboneListenerRaw
 public:
 	virtual void OnNotification(const FNotificationBackboneNotification& notification) = 0;
 
+	// Gets called by the feed. Override it to get what the feed knows about the notification, e.g. its dispatch delay.
+	// The notification is shared with all other listeners.
+	virtual void OnNotificationWithContext(const FNotificationBackboneNotification& notification, const FNotificationBackboneDispatchContext& context)
+	{
+		OnNotification(notification);
+	}
+
 	// Return an appropriate name so we know who is listening. Class name is always good.
 	virtual FName GetNotificationBackboneListenerName() = 0;
 };
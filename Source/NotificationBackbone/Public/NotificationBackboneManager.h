@@ -7,7 +7,13 @@
 #include "NotificationBackboneBPTypes.h"
 #include "NotificationBackboneListener.h"
 #include "Editor.h"
+#include "Containers/Ticker.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/GCObject.h"
+#include "Engine/StreamableManager.h"
 #include "NotificationBackboneNotificationFeed.h"
+#include "NotificationBackboneFeedPattern.h"
+#include "NotificationBackboneCapture.h"
 #include "QueueCustom.h"
 #include "NotificationBackboneDeclarations.h"
 
@@ -22,8 +28,23 @@
  *		Notifications that could not get dispatched because there is no subscriber, will get dropped.
  *	You can change that in the settings via the editor or config files.
  *  Each notification feed can have multiple subscribers.
+ *
+ *	Feed lifetime:
+ *	Feeds that become empty (no listeners, no notifications) are not destroyed right away. They stay idle for
+ *	idleFeedGracePeriod seconds, with at most maxIdleFeeds idle at once, so dispatching into a feed nobody listens to is cheap.
+ *	Destroyed feeds are recycled for the next feed that gets created.
+ *
+ *	Feed names and patterns:
+ *	Feed names can be hierarchical, e.g. "Combat.Damage.Fire". Listeners can register for a pattern instead of a feed,
+ *	e.g. "Combat.*" or "Combat.**" (see FNotificationBackboneFeedPattern). Patterns live in a trie. The listener gets added to every
+ *	matching feed when it registers and to every matching feed that gets created later, so dispatching does not care about patterns.
+ *
+ *	Feed handles:
+ *	Every call by name has to look up the feed. Producers that fire often can resolve a FNotificationFeedHandle once
+ *	and use the handle overloads instead. A handle whose feed got destroyed in the meantime falls back to the name
+ *	and gets refreshed in place.
  */
-class NOTIFICATIONBACKBONE_API FNotificationBackboneManager
+class NOTIFICATIONBACKBONE_API FNotificationBackboneManager : public FGCObject
 {
 public:
 	static FNotificationBackboneManager& Get()
@@ -34,46 +55,291 @@ public:
 	}
 
 	// This is for UObjects only
-	void RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed);
+	// The options let the feed filter the notifications for the listener (see FNotificationBackboneListenerOptions).
+	// The feed can be a pattern, also for the handle overloads. Unregister with the same pattern. Feeds other patterns of the listener match keep it.
+	void RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed, const FNotificationBackboneListenerOptions& options = FNotificationBackboneListenerOptions());
+	void RegisterForNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FNotificationFeedHandle& feed, const FNotificationBackboneListenerOptions& options = FNotificationBackboneListenerOptions());
 	void UnregisterFromNotificationsUObject(TScriptInterface<INotificationBackboneListener> listenerObject, FName feed);
 
 	// This is for raw objects only.
-	void RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed);
+	void RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed, const FNotificationBackboneListenerOptions& options = FNotificationBackboneListenerOptions());
+	void RegisterForNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FNotificationFeedHandle& feed, const FNotificationBackboneListenerOptions& options = FNotificationBackboneListenerOptions());
 	void UnregisterFromNotifications(TSharedRef<INotificationBackboneListenerRaw> listener, FName feed);
 
-	void DispatchNotification(const FNotificationBackboneNotification& notification);
+	/**
+	 * Can be called from any thread.
+	 * Notifications from other threads than the game thread go to an inbox first. The inbox gets drained
+	 * in one batch on the game thread each frame and the notifications get routed to their feeds.
+	 * Returns what the feed did with the notification, Deferred when called from another thread.
+	 */
+	ENotificationBackboneDispatchResult DispatchNotification(const FNotificationBackboneNotification& notification);
+	// Same as above, without copying the notification. It gets shared by the feed and all listeners.
+	ENotificationBackboneDispatchResult DispatchNotification(const FNotificationBackboneNotificationRef& notification);
+	// Same as above, but the handle decides the feed. The handle gets refreshed when it is stale.
+	ENotificationBackboneDispatchResult DispatchNotification(FNotificationFeedHandle& feed, const FNotificationBackboneNotification& notification);
+	ENotificationBackboneDispatchResult DispatchNotification(FNotificationFeedHandle& feed, const FNotificationBackboneNotificationRef& notification);
+
+	// Streams every notification that gets dispatched into a binary log, see FNotificationBackboneCapture.
+	// Notifications from other threads get recorded when the inbox gets drained. Stops the capture running already.
+	// Returns false when the file could not be created.
+	bool StartCapture(const FString& path);
+	void StopCapture();
+	bool IsCapturing() const
+	{
+		return capture.IsValid();
+	}
+
+	// Route all notifications that came in from other threads to their feeds now. Game thread only.
+	void FlushIncomingNotifications();
+
+	// Typed channels (see TNotificationChannel), by payload type and channel name. They are kept here, so all modules share the same channels.
+	// The manager drains the inboxes of the channels with its own and drops their listeners with its own.
+	struct FChannelEntry
+	{
+		TSharedPtr<void, ESPMode::ThreadSafe> channel;
+		// Called with the channel, game thread only.
+		void (*flushIncomingPayloads)(void* channel);
+		void (*clearListeners)(void* channel);
+	};
+	// Returns the channel, nullptr if there is none. Game thread only.
+	TSharedPtr<void, ESPMode::ThreadSafe> FindChannel(const FName& payloadType, const FName& channel) const
+	{
+		check(IsInGameThread());
+		const TMap<FName, int32>* typeChannels = channelIndices.Find(payloadType);
+		const int32* index = typeChannels ? typeChannels->Find(channel) : nullptr;
+		return index ? channels[*index].channel : nullptr;
+	}
+	// Game thread only.
+	void AddChannel(const FName& payloadType, const FName& channel, const FChannelEntry& entry)
+	{
+		check(IsInGameThread());
+		channelIndices.FindOrAdd(payloadType).Add(channel, channels.Add(entry));
+	}
+
+	// Fires at the end of FlushIncomingNotifications.
+	FSimpleMulticastDelegate& OnFlushIncomingNotifications()
+	{
+		return flushIncomingNotificationsDelegate;
+	}
+	// Fires when all listeners get cleared, e.g. at the end of PIE.
+	FSimpleMulticastDelegate& OnClearListeners()
+	{
+		return clearListenersDelegate;
+	}
+
+	// Dispatches a payload the type of the struct into a typed channel. Returns false when it got dropped.
+	typedef TFunction<bool(const FName& /*channel*/, const void* /*payload*/)> FChannelBridge;
+	void RegisterChannelBridge(const UScriptStruct* payloadStruct, FChannelBridge bridge)
+	{
+		channelBridges.Add(payloadStruct, MoveTemp(bridge));
+	}
+	// For Blueprints. Returns false when there is no channel for the struct or nobody listens.
+	bool DispatchChannelPayload(const UScriptStruct* payloadStruct, const FName& channel, const void* payload) const
+	{
+		const FChannelBridge* bridge = channelBridges.Find(payloadStruct);
+		return bridge && (*bridge)(channel, payload);
+	}
+
 	// Clear the notifications of the specified feed.
 	// Returns false when the feed does not exist
 	bool ClearNotificationFeedNotifications(const FName& feed);
 
+	// Sets the function that merges notifications with the same coalescing key for the feed (see ENotificationBackboneCoalesceMode::Merge).
+	// Stays set when the feed gets destroyed and created again. Pass an unbound delegate to remove it.
+	void SetNotificationFeedMergeFunction(const FName& feed, const FOnNotificationBackboneMerge& mergeFunction);
+
+	// The feed gets its OnScheduledDispatch called once delaySeconds passed. Game thread only.
+	// All delayed feeds share the tick of the manager, only feeds that are due get touched.
+	void ScheduleFeedDispatch(const FNotificationFeedHandle& feed, float delaySeconds);
+	// Same as above, but the next time the manager ticks. For feeds that ran out of budget.
+	void ScheduleFeedDispatchNextFrame(const FNotificationFeedHandle& feed);
+
+	// Feeds call these around a batch of notifications they dispatch. The outermost EndFeedDispatch works through the cascade.
+	void BeginFeedDispatch(const FName& feed);
+	void EndFeedDispatch();
+
+	// Whether some feed is notifying its listeners right now.
+	bool IsInFeedDispatch() const
+	{
+		return activeFeedDispatches > 0;
+	}
+
+	// A feed that wants to dispatch while listeners of a feed are notified (they dispatched or subscribed) does not dispatch
+	// within them. It goes on the cascade work list once, the outermost dispatch works through it breadth-first when its listeners are done.
+	// That keeps the stack flat and the order the same every time. Feeds beyond maxCascadeDepth go on the next frame instead,
+	// delayed feeds once their delay passed.
+	void DeferFeedDispatch(FNotificationBackboneNotificationFeed& feed);
+
+	// Number of the current frame. Counts the ticks of the manager, budgets are per frame.
+	uint64 GetFrameNumber() const
+	{
+		return frameNumber;
+	}
+
+	// Whether the global budget of this frame allows another dispatch.
+	bool HasDispatchBudgetLeft() const;
+	// Feeds report every dispatch and the time it took here.
+	void ConsumeDispatchBudget(uint64 dispatchCycles)
+	{
+		++frameDispatchCount;
+		frameDispatchCycles += dispatchCycles;
+	}
+
+	static uint64 MicrosecondsToCycles(float microseconds)
+	{
+		return (uint64)(microseconds * 0.000001 / FPlatformTime::GetSecondsPerCycle64());
+	}
+
+	// Loads the soft icons of the notifications.
+	FStreamableManager& GetStreamableManager()
+	{
+		return streamableManager;
+	}
+
+	// Returns the placeholder icon of the settings, nullptr if there is none. Gets loaded the first time it is needed.
+	UTexture2D* GetPlaceholderIcon();
+
+	// Keeps an icon from getting collected while async listeners might read it. Counted, game thread only.
+	void RetainAsyncListenerIcon(UTexture2D* icon);
+	void ReleaseAsyncListenerIcon(UTexture2D* icon);
+
+	// Keeps the icons of the queued notifications alive.
+	virtual void AddReferencedObjects(FReferenceCollector& collector) override;
+
+	// Returns the OnNotification function UObject listeners of the class implement, nullptr if there is none.
+	// Cached per class until the next garbage collection.
+	UFunction* FindListenerFunction(UClass* listenerClass);
+
+	// Returns the settings for the feed: the console override, the project settings or the defaults.
+	FNotificationBackboneFeedSettings GetFeedSettings(const FName& feed) const;
+	// Pushes the current settings into all live feeds. Called when the project settings change.
+	void ReloadFeedSettings();
+	// Changes the settings of the feed at runtime, on top of the project settings. Pushed into the feed right away.
+	void OverrideFeedSettings(const FName& feed, TFunctionRef<void(FNotificationBackboneFeedSettings&)> modify);
+	// Drops the override of the feed, all overrides for None.
+	void ClearFeedSettingsOverrides(const FName& feed);
+
+	// Returns the stats of the feed, including the ones of earlier feeds with the same name that got destroyed.
+	// Returns false when the feed has no stats since they got reset.
+	bool GetFeedStats(const FName& feed, FNotificationBackboneFeedStats& outStats) const;
+	// Stats of all feeds that have some, live or destroyed.
+	void GetAllFeedStats(TArray<FNotificationBackboneFeedStats>& outStats) const;
+	// Starts the stats of the feed over, the ones of all feeds for None.
+	void ResetFeedStats(const FName& feed);
+
+	// Returns a handle for the feed. The handle only carries the name when the feed does not exist yet.
+	FNotificationFeedHandle ResolveNotificationFeedHandle(const FName& feed) const;
+
 	/**
-	 * Do NOT hold the reference to the returned feed. When the feed is empty
-	 * we will get rid of it and create a new one if necessary. 
-	 * Returns the a pointer to the feed if it exists, nullptr otherwise
+	 * Returns the a pointer to the feed if it exists, nullptr otherwise.
+	 * Feeds only get destroyed when the manager ticks, so the pointer is safe to use until the next frame.
+	 * To keep a feed around, hold a FNotificationFeedHandle instead.
 	 */
-	TSharedRef<FNotificationBackboneNotificationFeed>* GetNotificationFeed(const FName& name)
+	FNotificationBackboneNotificationFeed* GetNotificationFeed(const FName& name) const
+	{
+		const int32* slotIndex = feedSlotIndices.Find(name);
+		return slotIndex ? feedSlots[*slotIndex].feed.Get() : nullptr;
+	}
+
+	// Same as above. Stale handles fall back to the name.
+	FNotificationBackboneNotificationFeed* GetNotificationFeed(const FNotificationFeedHandle& handle) const
 	{
-		return notificationFeeds.Find(name);
+		if (IsHandleValid(handle))
+		{
+			return feedSlots[handle.index].feed.Get();
+		}
+		return GetNotificationFeed(handle.feed);
 	}
 
 	bool GetDoesNotificationFeedExist(const FName& feed) const
 	{
-		return notificationFeeds.Contains(feed);
+		return feedSlotIndices.Contains(feed);
 	}
 
 	// Returns the names of the existing feeds
 	void GetNotificationFeedNames(TArray<FName>& feeds) const
 	{
-		feeds.Reset(notificationFeeds.Num());
-		notificationFeeds.GetKeys(feeds);
+		feeds.Reset(feedSlotIndices.Num());
+		feedSlotIndices.GetKeys(feeds);
 	}
 
 protected:
 	// Create a new notification feed if it does not exist yet.
-	virtual void CreateNotificationFeedWhenNotExists(const FName& feed);
-	virtual void RemoveNotificationFeedWhenEmpty(const FName& feed);
+	// Returns the index of the slot holding the feed.
+	virtual int32 CreateNotificationFeedWhenNotExists(const FName& feed);
+	// Moves an empty feed to the back of the idle list, a feed that is not empty anymore leaves the idle list.
+	virtual void RetireNotificationFeedWhenEmpty(int32 slotIndex);
+	// Destroys idle feeds that exceed the grace period or the max number of idle feeds.
+	virtual void EvictIdleNotificationFeeds();
+	// Frees the slot. The feed object gets recycled.
+	void DestroyNotificationFeed(int32 slotIndex);
+	// Keeps the counters of a feed that is about to be destroyed.
+	void RetireFeedCounters(const FNotificationBackboneNotificationFeed& feed);
+	// Stats entry of the destroyed feeds that did not fit into the settings' maxRetiredFeedStats.
+	static const FName RetiredFeedsName;
+
+	void LinkIdleFeedSlot(int32 slotIndex);
+	void UnlinkIdleFeedSlot(int32 slotIndex);
+
+	// Returns the slot index of the feed the handle points to, INDEX_NONE if there is no such feed.
+	// Stale handles get refreshed.
+	int32 ResolveFeedSlot(FNotificationFeedHandle& handle, bool bCreateWhenNotExists);
+
+	bool IsHandleValid(const FNotificationFeedHandle& handle) const
+	{
+		return feedSlots.IsValidIndex(handle.index) && feedSlots[handle.index].generation == handle.generation && feedSlots[handle.index].feed.IsValid();
+	}
 
 	virtual void ClearNotificationFeeds();
+
+	// Does the actual dispatch. Game thread only.
+	virtual ENotificationBackboneDispatchResult DispatchNotificationInternal(int32 slotIndex, const FNotificationBackboneNotificationRef& notification);
+	// Dispatches a notification the producer built on the stack. Only copies it when the feed takes it. Game thread only.
+	ENotificationBackboneDispatchResult DispatchNotificationCopy(int32 slotIndex, const FNotificationBackboneNotification& notification);
+	// Builds the shared notification for the feed in the slot, stamped with its dispatch delay.
+	FNotificationBackboneNotificationRef MakeNotificationForFeed(int32 slotIndex, const FNotificationBackboneNotification& notification) const;
+
+	// Gets fired every frame via the core ticker.
+	virtual bool Tick(float deltaSeconds);
+
+	// Lets all feeds that are due dispatch. Feeds that missed several delays during a long frame catch up
+	// in order of their due times, one dispatch per missed delay. Stops when the global budget is used up.
+	virtual void DispatchScheduledFeeds();
+	// Fires the feed and schedules it again if it wants to.
+	void RunScheduledFeed(int32 slotIndex, uint32 generation, double dueSeconds);
+
+	// Dispatches the deferred feeds in order, including the ones deferred meanwhile.
+	void RunCascade();
+	// The feeds from the root dispatch to the one that went too deep, only the cycle if there is one. "A -> B -> A"
+	FString DescribeCascade(int32 entryIndex, const FName& deferredFeed) const;
+
+	// Listeners registered for a pattern.
+	struct FPatternSubscription
+	{
+		FName pattern;
+		TWeakObjectPtr<UObject> object;
+		TWeakPtr<INotificationBackboneListenerRaw> raw;
+		const void* key = nullptr;
+		FNotificationBackboneListenerOptions options;
+
+		bool IsStale() const
+		{
+			return object.IsExplicitlyNull() ? !raw.IsValid() : !object.IsValid();
+		}
+	};
+
+	void RegisterPatternSubscription(const FPatternSubscription& subscription);
+	void UnregisterPatternSubscription(const FName& pattern, const void* key);
+	// Adds the listener of the subscription to the feed.
+	void ApplyPatternSubscription(const FPatternSubscription& subscription, FNotificationBackboneNotificationFeed& feed);
+	// Adds the listeners of all matching patterns to a new feed.
+	void ApplyPatternSubscriptions(int32 slotIndex);
+	// Walks the trie along the segments of a feed name and collects the subscriptions of all patterns that match.
+	void CollectPatternSubscriptions(int32 nodeIndex, const TArray<FName>& feedSegments, int32 segment, TArray<int32>& outSubscriptions) const;
+	// Returns the node of the pattern, nullptr when the pattern has none. bCreate creates the missing nodes.
+	// Patterns ending with "**" end at the node before.
+	int32 FindPatternNode(const TArray<FName>& patternSegments, bool bCreate);
+
 	virtual void ClearListeners()
 	{
 		ClearNotificationFeeds();
@@ -82,15 +348,28 @@ protected:
 	virtual void OnEndPlayInEditor(bool bIsSimulating)
 	{
 		ClearListeners();
+		for (FChannelEntry& channel : channels)
+		{
+			channel.clearListeners(channel.channel.Get());
+		}
+		clearListenersDelegate.Broadcast();
 	}
 
+	// Sweeps the UObject listeners that got garbage collected out of the feeds.
+	virtual void OnPostGarbageCollect();
+
 	virtual ~FNotificationBackboneManager()
 	{
+		FTicker::GetCoreTicker().RemoveTicker(tickerDelegateHandle);
+		FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
 		ClearListeners();
 	}
 	FNotificationBackboneManager()
 	{
 		FEditorDelegates::EndPIE.AddRaw(this, &FNotificationBackboneManager::OnEndPlayInEditor);
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FNotificationBackboneManager::OnPostGarbageCollect);
+		// The core ticker gets created before us this way, thus it also outlives us.
+		tickerDelegateHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FNotificationBackboneManager::Tick));
 	}
 private:
 	// Make singleton class
@@ -100,6 +379,132 @@ private:
 	FNotificationBackboneManager& operator=(FNotificationBackboneManager&& rvalue) = delete;
 
 #pragma region Notification
-	TMap<FName, TSharedRef<FNotificationBackboneNotificationFeed>> notificationFeeds;
+	struct FNotificationFeedSlot
+	{
+		TSharedPtr<FNotificationBackboneNotificationFeed> feed;
+		// Gets raised every time the slot loses its feed, so old handles do not match anymore.
+		uint32 generation = 0;
+
+		// Idle list, in order of the time the feeds became empty.
+		bool bIsIdle = false;
+		double idleSinceSeconds = 0.0;
+		int32 idlePrev = INDEX_NONE;
+		int32 idleNext = INDEX_NONE;
+	};
+
+	// Feeds live in slots, so handles can reach them by index.
+	// Slots are never removed, only recycled, to keep the generations going up.
+	TArray<FNotificationFeedSlot> feedSlots;
+	TArray<int32> freeFeedSlots;
+	TMap<FName, int32> feedSlotIndices;
+
+	// Oldest idle feed is the head.
+	int32 idleFeedsHead = INDEX_NONE;
+	int32 idleFeedsTail = INDEX_NONE;
+	int32 numIdleFeeds = 0;
+
+	// Destroyed feeds waiting to be reused.
+	TArray<TSharedPtr<FNotificationBackboneNotificationFeed>> recycledFeeds;
+
+	struct FScheduledFeedDispatch
+	{
+		double dueSeconds;
+		// Tie breaker, so feeds due at the same time go in the order they got scheduled.
+		uint64 order;
+		int32 slotIndex;
+		uint32 generation;
+
+		bool operator<(const FScheduledFeedDispatch& other) const
+		{
+			return dueSeconds < other.dueSeconds || (dueSeconds == other.dueSeconds && order < other.order);
+		}
+	};
+
+	// Min heap of delayed feeds by due time. Entries of destroyed feeds get skipped when they come up.
+	TArray<FScheduledFeedDispatch> scheduledFeeds;
+	uint64 scheduleOrder = 0;
+	// Time of the scheduler. Sum of the delta times of our ticks.
+	double schedulerSeconds = 0.0;
+	// Feeds that ran out of budget and go on the next frame.
+	TArray<FNotificationFeedHandle> nextFrameFeeds;
+
+	struct FCascadeEntry
+	{
+		FNotificationFeedHandle feed;
+		// Entry whose listeners deferred us, INDEX_NONE for the root dispatch.
+		int32 parent;
+		int32 depth;
+	};
+
+	// Cascade work list of the current root dispatch, in the order the feeds got deferred. Reset once it is through.
+	TArray<FCascadeEntry> cascade;
+	// Feed of the root dispatch, the one the cascade started from.
+	FName cascadeRootFeed;
+	// Entry being dispatched, INDEX_NONE while the root dispatch runs.
+	int32 currentCascadeEntry = INDEX_NONE;
+	int32 activeFeedDispatches = 0;
+	bool bRunningCascade = false;
+
+	// Global budget, what all feeds dispatched in the current frame.
+	uint64 frameNumber = 0;
+	int32 frameDispatchCount = 0;
+	uint64 frameDispatchCycles = 0;
+
+	FStreamableManager streamableManager;
+	UTexture2D* placeholderIcon = nullptr;
+	// Icons of dispatches whose async listeners are still busy, once per dispatch.
+	TArray<UTexture2D*> asyncListenerIcons;
+	bool bPlaceholderIconLoaded = false;
+
+	// OnNotification per listener class, see FindListenerFunction.
+	TMap<const UClass*, UFunction*> listenerFunctions;
+
+	// Counters of destroyed feeds by feed name, so idle feeds getting evicted do not lose their stats.
+	// At most maxRetiredFeedStats of them, the rest goes into the entry of RetiredFeedsName.
+	TMap<FName, FNotificationBackboneFeedCounters> retiredFeedCounters;
+	// Names in retiredFeedCounters in the order they got there, without RetiredFeedsName.
+	TArray<FName> retiredFeedNames;
+
+	// Settings set at runtime, see OverrideFeedSettings.
+	TMap<FName, FNotificationBackboneFeedSettings> feedSettingsOverrides;
+
+	// Merge functions by feed name. Feeds pick them up when they get created.
+	TMap<FName, FOnNotificationBackboneMerge> feedMergeFunctions;
+
+	// Notifications dispatched from other threads. Multiple producers, the game thread is the only consumer.
+	TQueueCustom<FNotificationBackboneNotificationPtr, EQueueMode::Mpsc> incomingNotifications;
+
+	// Set while capturing, see StartCapture.
+	TUniquePtr<FNotificationBackboneCapture> capture;
 #pragma endregion Notification
+
+#pragma region Pattern
+	struct FPatternTrieNode
+	{
+		// Segment -> child node. "*" is a child as well.
+		TMap<FName, int32> children;
+		// Patterns that end here.
+		TArray<int32> subscriptions;
+		// Patterns that end here with "**".
+		TArray<int32> deepSubscriptions;
+	};
+
+	// Root is the first node. Nodes are never removed, there are only as many as there are distinct patterns.
+	TArray<FPatternTrieNode> patternTrie;
+	TSparseArray<FPatternSubscription> patternSubscriptions;
+#pragma endregion Pattern
+
+#pragma region Channel
+	// Channels are never removed. Listeners may create channels while we go through them, so they get visited by index.
+	TArray<FChannelEntry> channels;
+	// Payload type -> channel name -> index into channels, see FindChannel.
+	TMap<FName, TMap<FName, int32>> channelIndices;
+	FSimpleMulticastDelegate flushIncomingNotificationsDelegate;
+	FSimpleMulticastDelegate clearListenersDelegate;
+	// Payload struct -> dispatches into the typed channels of that payload.
+	TMap<const UScriptStruct*, FChannelBridge> channelBridges;
+#pragma endregion Channel
+
+	// Handle to our delegate in the core ticker
+	FDelegateHandle tickerDelegateHandle;
 };
@@ -4,7 +4,11 @@
 
 #include "NotificationBackboneSettings.h"
 #include "NotificationBackboneDeclarations.h"
-#include "QueueCustom.h"
+#include "NotificationBackboneStats.h"
+#include "NotificationBackboneTrace.h"
+#include "RingQueue.h"
+#include "Engine/StreamableManager.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "CoreMinimal.h"
 
 /**
@@ -17,7 +21,12 @@ public:
 	FNotificationBackboneNotificationFeed(const FName& in_feedName);
 	~FNotificationBackboneNotificationFeed();
 
-	void EnqueueNotification(const FNotificationBackboneNotification& notification);
+	ENotificationBackboneDispatchResult EnqueueNotification(const FNotificationBackboneNotificationRef& notification);
+
+	const FName& GetFeedName() const
+	{
+		return feedName;
+	}
 
 	bool GetDoesHaveListeners() const
 	{
@@ -26,30 +35,65 @@ public:
 
 	bool GetDoesHaveNotifications() const
 	{
-		return !notificationQueue.IsEmpty();
+		return numQueuedNotifications != 0;
 	}
 
+	// Listeners that subscribed during a dispatch count already, the ones that unsubscribed do not count anymore.
 	uint32 GetNumListeners() const
 	{
-		return listenersObject.Num() + listenersRaw.Num();
+		return listeners.Num() + numKeyedListeners - numRemovedListeners + pendingListeners.Num();
+	}
+
+	// Whether we are in the middle of sending out a notification.
+	bool IsDispatching() const
+	{
+		return dispatchDepth > 0;
 	}
 
+	// Completes once the async listeners (see FNotificationBackboneListenerOptions::bAsync) are done with everything dispatched so far.
+	// nullptr when none of them is busy. Game thread only.
+	FGraphEventRef GetAsyncListenerCompletion();
+
 	uint32 GetNumNotifications() const
 	{
-		return notificationQueue.Num();
+		return numQueuedNotifications;
+	}
+
+	uint32 GetNumNotifications(ENotificationBackbonePriority priority) const
+	{
+		return notificationLanes[(int32)priority].Num();
+	}
+
+	// Number of notifications lost because the feed was full.
+	uint64 GetNumDroppedNotifications() const
+	{
+		return counters.numDroppedOverflow;
+	}
+
+	// What we did since we got created for our feed or the counters got reset.
+	const FNotificationBackboneFeedCounters& GetCounters() const
+	{
+		return counters;
+	}
+
+	void ResetCounters()
+	{
+		counters = FNotificationBackboneFeedCounters();
 	}
 
-	// This only holds until the feed is completely empty (no listeners, no notifications), as the feed will get destroyed.
+	// This only holds until the feed got destroyed after being completely empty (no listeners, no notifications) for a while.
 	// This can be useful for map changes or when you have to load, during a NPC conversation, while the player is in the inventory, ...
 	void BlockDispatching()
 	{
+		NOTIFICATIONBACKBONE_TRACE(Block, 0, feedName);
 		bBlockDispatch = true;
 	}
 
 	void ContinueDispatching()
 	{
+		NOTIFICATIONBACKBONE_TRACE(Unblock, 0, feedName);
 		bBlockDispatch = false;
-		StartDispatchTicker();
+		StartDispatching();
 	}
 
 	// Returns whether the feed blocked and does not dispatch or not.
@@ -61,68 +105,329 @@ public:
 	void GetListenerNames(TArray<FString>& outNames) const
 	{
 		outNames.Reset(GetNumListeners());
-		// Object
-		for (const TScriptInterface<INotificationBackboneListener>& listener : listenersObject)
+		for (const FListenerEntry& listener : listeners)
 		{
-			if (listener.GetObject() && listener.GetObject()->IsValidLowLevelFast())
+			if (!listener.bRemoved)
 			{
-				outNames.Add(listener.GetObject()->GetName());
+				listener.AddName(outNames);
 			}
 		}
-
-		//Raw
-		for (const TWeakPtr<INotificationBackboneListenerRaw>& listener : listenersRaw)
+		for (const TPair<FName, TArray<FListenerEntry>>& bucket : keyedListeners)
 		{
-			TSharedPtr<INotificationBackboneListenerRaw> pinnedRaw = listener.Pin();
-			if (pinnedRaw.IsValid())
+			for (const FListenerEntry& listener : bucket.Value)
 			{
-				outNames.Add(pinnedRaw->GetNotificationBackboneListenerName().ToString());
+				if (!listener.bRemoved)
+				{
+					listener.AddName(outNames);
+				}
 			}
 		}
+		for (const FListenerEntry& listener : pendingListeners)
+		{
+			listener.AddName(outNames);
+		}
 	}
 
 private:
+	// A listener, either a UObject or a raw C++ object.
+	struct FListenerEntry
+	{
+		// UObject listener. Weak, we must not keep it from being garbage collected.
+		// Dead ones get swept after each garbage collection.
+		TWeakObjectPtr<UObject> object;
+		TWeakPtr<INotificationBackboneListenerRaw> raw; // Raw C++ listener
+
+		// C++ implementers of the interface get called directly, only valid while object is.
+		// Blueprint implementers go through ProcessEvent.
+		INotificationBackboneListener* nativeObject = nullptr;
+
+		// Identity of the listener, the object or the raw pointer. Used to find the entry again.
+		const void* key = nullptr;
+
+		bool bIsObject = false;
+		// Raw listener that gets called on the task graph.
+		bool bAsync = false;
+
+		// Unsubscribed during a dispatch. Gets skipped and removed once the dispatch is over.
+		bool bRemoved = false;
+
+		// See FNotificationBackboneListenerOptions. Listeners with a filter key live in the bucket of their key.
+		FName filterKey;
+		ENotificationBackbonePriority minPriority = ENotificationBackbonePriority::Low;
+		TFunction<bool(const FNotificationBackboneNotification&)> predicate;
+
+		void SetOptions(const FNotificationBackboneListenerOptions& options)
+		{
+			filterKey = options.filterKey;
+			minPriority = options.minPriority;
+			predicate = options.predicate;
+			bAsync = options.bAsync;
+		}
+
+		// The routing key got checked by picking the bucket already.
+		bool PassesFilter(const FNotificationBackboneNotification& notification) const
+		{
+			return notification.priority >= minPriority && (!predicate || predicate(notification));
+		}
+
+		bool IsStale() const
+		{
+			return bIsObject ? !object.IsValid() : !raw.IsValid();
+		}
+
+		void AddName(TArray<FString>& outNames) const
+		{
+			if (bIsObject)
+			{
+				if (UObject* listenerObject = object.Get())
+				{
+					outNames.Add(listenerObject->GetName());
+				}
+			}
+			else
+			{
+				TSharedPtr<INotificationBackboneListenerRaw> pinnedRaw = raw.Pin();
+				if (pinnedRaw.IsValid())
+				{
+					outNames.Add(pinnedRaw->GetNotificationBackboneListenerName().ToString());
+				}
+			}
+		}
+	};
+
+	// Look up the settings that belong to our feed.
+	void LoadSettings();
+	// Takes over new settings, also while the feed is live.
+	void ApplySettings(const FNotificationBackboneFeedSettings& newSettings);
+
+	// Makes a recycled feed ready to be used for another feed name. Must not have listeners nor notifications.
+	void ResetForFeed(const FName& in_feedName);
+
 	// For raw objects
-	void AddListener(TSharedRef<INotificationBackboneListenerRaw> listener);
+	void AddListener(TSharedRef<INotificationBackboneListenerRaw> listener, const FNotificationBackboneListenerOptions& options);
 	void RemoveListener(TSharedRef<INotificationBackboneListenerRaw> listener);
 
 	//For UObjects
-	void AddListenerObject(TScriptInterface<INotificationBackboneListener> listener);
+	void AddListenerObject(TScriptInterface<INotificationBackboneListener> listener, const FNotificationBackboneListenerOptions& options);
 	void RemoveListenerObject(TScriptInterface<INotificationBackboneListener> listener);
 
+	// While we dispatch, adding and removing only gets noted down. The listener array stays untouched until the dispatch is over.
+	// A listener that is subscribed already gets its entry replaced, with the new options.
+	void AddListenerEntry(const FListenerEntry& entry);
+	void RemoveListenerEntry(const void* key);
+	// Takes the subscribed listener out, or marks it removed while we dispatch. Leaves pending listeners and the notifications alone.
+	void EraseListenerEntry(const void* key);
+	// Returns the subscribed listener, nullptr if there is none. Pending listeners do not count.
+	FListenerEntry* FindListenerEntry(const void* key);
+	// Adds the listener to the array or the bucket of its filter key. Not while we dispatch.
+	void InsertListenerEntry(const FListenerEntry& entry);
+
+	// Calls the function for all subscribed listeners, the ones with filter key as well.
+	template<typename FunctionType>
+	void ForEachListener(FunctionType function)
+	{
+		for (FListenerEntry& listener : listeners)
+		{
+			function(listener);
+		}
+		for (TPair<FName, TArray<FListenerEntry>>& bucket : keyedListeners)
+		{
+			for (FListenerEntry& listener : bucket.Value)
+			{
+				function(listener);
+			}
+		}
+	}
+
+	// Marks the listener as removed, the dispatch is going on.
+	void MarkListenerRemoved(FListenerEntry& entry);
+	void ApplyPendingListenerChanges();
+
+	// Parameters of OnNotification for the Blueprint listeners. Built once per notification, see NotifyObjectListener.
+	struct FObjectListenerParams;
+
+	// Calls the listener if its filter lets the notification through.
+	// UObject listeners get the notification of objectParams, see DispatchNotificationFromQueue.
+	void NotifyListener(FListenerEntry& listener, const FNotificationBackboneNotificationRef& notification, FObjectListenerParams& objectParams, const FNotificationBackboneDispatchContext& context, uint64 notificationId);
+
+	// Hands the call to the task graph. The task only gets a raw pointer, asyncListenerRefs keeps the listener alive.
+	// It waits for the call of the notification before to the same listener.
+	void NotifyListenerAsync(const TSharedPtr<INotificationBackboneListenerRaw>& listener, const FNotificationBackboneNotificationRef& notification, const FNotificationBackboneDispatchContext& context, uint64 notificationId);
+	// Once all listeners got the notification. Keeps the icon of the dispatch alive until the calls are done,
+	// then releases it and the listeners on the game thread.
+	void FinishAsyncListeners(UTexture2D* icon);
+
+	// Calls OnNotification on a UObject listener, skipping reflection for C++ implementers.
+	void NotifyObjectListener(const FListenerEntry& listener, UObject* listenerObject, FObjectListenerParams& objectParams);
+
+	// Keeps the objects of the queued notifications alive. Called by the manager.
+	void AddReferencedObjects(FReferenceCollector& collector);
+
+	// Removes listeners that are gone. The manager calls this after each garbage collection.
+	void PurgeStaleListeners();
+
 	// Clear the pending notifications of a feed.
 	void ClearNotifications()
 	{
-		notificationQueue.Empty();
+		if (numQueuedNotifications != 0)
+		{
+			NOTIFICATIONBACKBONE_TRACE(Clear, 0, feedName, NAME_None, numQueuedNotifications);
+		}
+		counters.numCleared += numQueuedNotifications;
+		for (int32 lane = 0; lane < NumNotificationLanes; ++lane)
+		{
+			notificationLanes[lane].Empty();
+			laneStarvation[lane] = 0;
+		}
+		nonEmptyLanes = 0;
+		numQueuedNotifications = 0;
+		coalescingIndex.Empty();
+
+		for (TPair<FSoftObjectPath, FIconLoad>& iconLoad : iconLoads)
+		{
+			// No handle when the load failed or finished synchronously.
+			if (iconLoad.Value.handle.IsValid())
+			{
+				iconLoad.Value.handle->CancelHandle();
+			}
+		}
+		iconLoads.Empty();
 	}
 
+	// Soft icons get loaded when the notification comes in and stay loaded until it leaves the feed.
+	// Notifications with the same icon share the load.
+	void RetainIcon(const FNotificationBackboneNotification& notification);
+	void ReleaseIcon(const FNotificationBackboneNotification& notification);
+	// Whether the next notification waits for its icon, see ENotificationBackboneIconLoadPolicy::HoldBack.
+	bool IsWaitingForIcon() const;
+
+	// Queue access that keeps the lanes, the counts and the coalescing index in sync.
+	struct FQueuedNotification;
+	void EnqueueIntoLane(const FNotificationBackboneNotificationRef& notification, uint64 notificationId, bool bIndexCoalescingKey);
+	bool DequeueNotification(FQueuedNotification& outQueued);
+	void DropOldestNotification();
+	void ForgetCoalescingKey(const FNotificationBackboneNotification& notification, int32 lane, uint64 sequence);
+	void OnLaneShrunk(int32 lane);
+
+	// Highest lane with notifications, unless a lower lane waited for too long. INDEX_NONE when all lanes are empty.
+	int32 SelectLaneToDispatch() const;
+
+	// Merges the incoming notification into the queued one, according to our coalesce mode.
+	// Queued notifications are shared, so the queued one gets replaced by the merge result.
+	void CoalesceNotification(FNotificationBackboneNotificationPtr& queued, const FNotificationBackboneNotificationRef& incoming);
+
+	// Dispatches a single notification. Returns false when there was nothing to dispatch or nobody to dispatch to.
+	bool DispatchNotificationFromQueue();
+
+	// Dispatches up to maxCount notifications, as long as the budgets of this frame allow it. Returns the number dispatched.
+	int32 DispatchNotificationBatch(int32 maxCount);
+
+	// Whether our budget and the global budget of this frame allow another dispatch.
+	bool HasFrameBudgetLeft();
+
 	/**
-	 * This function gets fired via the ticker.
-	 * If it returns true, the delay is reset and will fire again.
-	 * If it returns false, the ticker does not consider us anymore.
+	 * This function gets fired by the scheduler of the manager when our delay passed, or the next frame when we ran out of budget.
+	 * If it returns true, we want to get fired again after outNextDelay seconds, 0 for the next frame.
+	 * If it returns false, the scheduler does not consider us anymore.
 	 */
-	bool DispatchNotificationFromQueue(float deltaSeconds = 0.f);
+	bool OnScheduledDispatch(float& outNextDelay);
+
+	void StartDispatching();
+
+	// Drops the next notification when nobody listens and we do not cache, counted and traced. Returns true when it got dropped.
+	// The manager asks before it builds the shared notification, so broadcasting into an unused feed allocates nothing.
+	bool DropWithoutListeners();
+
+	bool CanDispatch() const
+	{
+		return !bBlockDispatch && GetDoesHaveListeners() && GetDoesHaveNotifications() && !IsWaitingForIcon();
+	}
+
+	bool IsDelayed() const
+	{
+		return !FMath::IsNearlyZero(settings.dispatchDelay);
+	}
+
+	// Listeners without filter key. Dense, so a dispatch walks contiguous memory.
+	TArray<FListenerEntry> listeners;
+	// Listener key -> index in listeners
+	TMap<const void*, int32> listenerIndices;
+	// Listeners with filter key, by filter key. A notification with routing key only wakes up the bucket of its key.
+	TMap<FName, TArray<FListenerEntry>> keyedListeners;
+	// Listener key -> filter key
+	TMap<const void*, FName> keyedListenerKeys;
+	int32 numKeyedListeners = 0;
+	// Subscribed during a dispatch, get added once the dispatch is over.
+	TArray<FListenerEntry> pendingListeners;
+	// Number of listeners marked as removed.
+	int32 numRemovedListeners = 0;
+	// Number of UObject listeners, feeds without any skip the sweep after garbage collection.
+	int32 numObjectListeners = 0;
+	// Nested dispatches, listeners might dispatch to us again.
+	int32 dispatchDepth = 0;
+
+	// Async listener calls of the notification being dispatched, until FinishAsyncListeners.
+	FGraphEventArray asyncListenerEvents;
+	TArray<TSharedPtr<INotificationBackboneListenerRaw>> asyncListenerRefs;
+	// Last call per async listener, the next call waits for it. Done ones get dropped in FinishAsyncListeners.
+	TMap<INotificationBackboneListenerRaw*, FGraphEventRef> asyncListenerTails;
+	// One per notification with async listeners still busy.
+	FGraphEventArray asyncCompletions;
 
-	void StartDispatchTicker();
+	// One queue per priority, indexed by ENotificationBackbonePriority.
+	static const int32 NumNotificationLanes = (int32)ENotificationBackbonePriority::Critical + 1;
+	struct FQueuedNotification
+	{
+		FNotificationBackboneNotificationPtr notification;
+		// When it came in, for the latency stats. Coalesced notifications keep the time of the first one.
+		uint64 enqueueCycles;
+		// See FNotificationBackboneTrace. Coalesced notifications keep the id of the first one.
+		uint64 id;
+	};
+	TRingQueue<FQueuedNotification> notificationLanes[NumNotificationLanes];
+	// Dispatches of higher priority notifications since a lane got served last.
+	int32 laneStarvation[NumNotificationLanes] = {};
+	// Bit per lane that has notifications.
+	uint32 nonEmptyLanes = 0;
+	uint32 numQueuedNotifications = 0;
+
+	FNotificationBackboneFeedCounters counters;
 
-	TSet<TScriptInterface<INotificationBackboneListener>> listenersObject; // UObject listeners
-	TSet<TWeakPtr<INotificationBackboneListenerRaw>> listenersRaw;	// Raw C++ listeners
+	struct FCoalescingSlot
+	{
+		int32 lane;
+		uint64 sequence;
+	};
+	// Coalescing key -> where the queued notification with that key is.
+	TMap<FName, FCoalescingSlot> coalescingIndex;
+	struct FIconLoad
+	{
+		TSharedPtr<FStreamableHandle> handle;
+		int32 numNotifications = 0;
+	};
+	// Soft icons of the queued notifications being loaded or kept loaded.
+	TMap<FSoftObjectPath, FIconLoad> iconLoads;
 
-	TQueueCustom<FNotificationBackboneNotification, EQueueMode::Spsc> notificationQueue;
+	// Used by ENotificationBackboneCoalesceMode::Merge. Set by the manager.
+	FOnNotificationBackboneMerge mergeFunction;
 
 	// Name of the feed this object is for.
 	FName feedName;
 
+	// Where the manager keeps us. Set by the manager.
+	FNotificationFeedHandle selfHandle;
+
 	FNotificationBackboneFeedSettings settings;
 
-	// Delegate that connects the ticker to our function
-	FTickerDelegate tickerDelegate;
-	// Handle to the delegate in the ticker
-	FDelegateHandle tickerDelegateHandle;
-	// The ticker is a bit of a mess. It has no way of querying it for an active delegate,
-	// nor does it invalidate the handle in case the in case the ticker finished (see return value
-	// of ticked function). Thus we try to keep track of the ticker on our own.
-	bool bIsTickerActive = false;
+	// Whether the scheduler of the manager will call us once our delay passed.
+	bool bIsScheduled = false;
+	// Whether we are on the cascade work list of the manager, see FNotificationBackboneManager::DeferFeedDispatch.
+	bool bCascadePending = false;
+
+	// What we dispatched in the frame (manager tick) budgetFrame.
+	uint64 budgetFrame = 0;
+	int32 frameDispatchCount = 0;
+	uint64 frameDispatchCycles = 0;
 
 	bool bBlockDispatch = false;
 };
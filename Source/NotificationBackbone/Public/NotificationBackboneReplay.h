@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Commandlets/Commandlet.h"
+#include "NotificationBackboneBPTypes.h"
+#include "NotificationBackboneReplay.generated.h"
+
+/**
+ * Dispatches the notifications of a capture (see FNotificationBackboneCapture) again, to load test listeners and backbone changes
+ * with recorded traffic. The file gets streamed, only the next notification is in memory.
+ *
+ * Speed 1 replays at the original pace, 2 twice as fast and so on. Speed 0 replays as fast as possible: every tick dispatches one frame
+ * of the capture, so the feeds still see the notifications frame by frame.
+ * Game thread only. Once started, the core ticker drives it.
+ */
+class NOTIFICATIONBACKBONE_API FNotificationBackboneReplay
+{
+public:
+	// Returns nullptr when the file could not be opened or is no capture.
+	static TSharedPtr<FNotificationBackboneReplay> Open(const FString& path);
+
+	~FNotificationBackboneReplay();
+
+	// maxPerTick caps the notifications per tick, 0 for no cap. in_frameSeconds is the time of the capture a tick replays at speed 0.
+	void Start(float in_speed, int32 in_maxPerTick = 0, float in_frameSeconds = 1.f / 60.f);
+	void Stop();
+
+	// Dispatches what is due after elapsedSeconds more passed. Returns false once the capture is through.
+	bool Advance(float elapsedSeconds);
+
+	bool IsFinished() const
+	{
+		return !bHasPending;
+	}
+
+	uint64 GetNumReplayed() const
+	{
+		return numReplayed;
+	}
+
+	const FString& GetPath() const
+	{
+		return path;
+	}
+
+private:
+	FNotificationBackboneReplay(const FString& in_path, TUniquePtr<FArchive>&& in_reader);
+
+	// Reads the next notification into pendingNotification. Returns false at the end of the file or when it is broken.
+	bool ReadNext();
+	FName ReadName();
+
+	bool Tick(float deltaSeconds);
+
+	FString path;
+	TUniquePtr<FArchive> reader;
+	TArray<FName> names;
+
+	FNotificationBackboneNotification pendingNotification;
+	// Time of the pending notification in the capture.
+	double pendingSeconds = 0.0;
+	bool bHasPending = false;
+
+	// Time in the capture we replayed up to.
+	double replaySeconds = 0.0;
+	float speed = 1.f;
+	int32 maxPerTick = 0;
+	float frameSeconds = 1.f / 60.f;
+	uint64 numReplayed = 0;
+	double startSeconds = 0.0;
+
+	FDelegateHandle tickerDelegateHandle;
+};
+
+/**
+ * Replays a capture headless:
+ *	UE4Editor-Cmd <Project>.uproject -run=NotificationBackboneReplay -nullrhi -file=<Capture> [-speed=1] [-fps=60]
+ * Ticks the core ticker and the game thread tasks at the given rate until the capture is through, without waiting between frames
+ * at speed 0. Listeners are whatever the loaded modules registered.
+ */
+UCLASS()
+class NOTIFICATIONBACKBONE_API UNotificationBackboneReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UNotificationBackboneReplayCommandlet();
+
+	virtual int32 Main(const FString& params) override;
+
+private:
+	static void TickFrame(float frameSeconds);
+};
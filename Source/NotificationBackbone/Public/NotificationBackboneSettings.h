@@ -25,8 +25,60 @@ public:
 		return GetDefault<UNotificationBackboneSettings>();
 	}
 
+	// Returns the settings of the feed, the first matching pattern when the feed has none of its own. nullptr when nothing matches.
+	// Hash lookup, the index gets rebuilt whenever the settings change.
+	const FNotificationBackboneFeedSettings* FindFeedSettings(const FName& feed) const;
+
+	virtual void PostInitProperties() override;
+	virtual void PostReloadConfig(UProperty* PropertyThatWasLoaded) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 	// Per notification feed settings. 
 	UPROPERTY(config, EditAnywhere, Category = "Notifications")
 		TArray<FNotificationBackboneFeedSettings> feedSettings;
 
+	// Max number of notifications all feeds together dispatch per frame. The rest waits for the next frame. 0 for no limit.
+	UPROPERTY(config, EditAnywhere, Category = "Budget", meta = (ClampMin = "0"))
+		int32 maxDispatchesPerFrame = 0;
+
+	// Max time in microseconds all feeds together spend dispatching per frame. The rest waits for the next frame. 0 for no limit.
+	UPROPERTY(config, EditAnywhere, Category = "Budget", meta = (ClampMin = "0"))
+		float maxDispatchMicrosecondsPerFrame = 0.f;
+
+	// Max length of a chain of feeds whose listeners dispatch into the next one (damage -> combat log -> achievements) within a frame.
+	// Feeds further down go on the next frame, delayed feeds after their delay, and a warning names the chain, usually a cycle. 0 for no limit.
+	UPROPERTY(config, EditAnywhere, Category = "Budget", meta = (ClampMin = "0"))
+		int32 maxCascadeDepth = 16;
+
+	// Seconds an empty feed (no listeners, no notifications) is kept idle before it gets destroyed.
+	// Idle feeds cost nothing to dispatch into and keep their handles valid.
+	UPROPERTY(config, EditAnywhere, Category = "Feeds", meta = (ClampMin = "0"))
+		float idleFeedGracePeriod = 10.f;
+
+	// Max number of idle feeds. When there are more, the ones idle the longest get destroyed first.
+	// Also the max number of destroyed feed objects we keep to recycle.
+	UPROPERTY(config, EditAnywhere, Category = "Feeds", meta = (ClampMin = "0"))
+		int32 maxIdleFeeds = 64;
+
+	// Max number of destroyed feeds whose stats are kept by feed name. Beyond that the stats of the ones destroyed first get folded
+	// into a single "NotificationBackbone.RetiredFeeds" entry, so feeds with generated names do not grow the stats forever.
+	UPROPERTY(config, EditAnywhere, Category = "Feeds", meta = (ClampMin = "0"))
+		int32 maxRetiredFeedStats = 256;
+
+	// Icon for notifications whose soft icon is not loaded yet, for feeds with the Placeholder icon load policy.
+	UPROPERTY(config, EditAnywhere, Category = "Icons")
+		TSoftObjectPtr<UTexture2D> placeholderIcon;
+
+private:
+	// Rebuilds the index and pushes the new settings into the live feeds.
+	void OnFeedSettingsChanged();
+	void RebuildFeedSettingsIndex();
+
+	// Feed name -> index in feedSettings. Only the first entry of a feed counts.
+	TMap<FName, int32> feedSettingsIndex;
+	// Split patterns and their index in feedSettings, in order.
+	TArray<TPair<TArray<FName>, int32>> patternFeedSettings;
+
 };
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "NotificationBackboneBPTypes.h"
+
+// "stat NotificationBackbone"
+DECLARE_STATS_GROUP(TEXT("NotificationBackbone"), STATGROUP_NotificationBackbone, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("DispatchNotification"), STAT_NotificationBackbone_DispatchNotification, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("DispatchNotificationFromQueue"), STAT_NotificationBackbone_DispatchNotificationFromQueue, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("NotifyListeners"), STAT_NotificationBackbone_NotifyListeners, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AsyncListener"), STAT_NotificationBackbone_AsyncListener, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FlushIncomingNotifications"), STAT_NotificationBackbone_FlushIncomingNotifications, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_NotificationBackbone_Tick, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Notifications dispatched"), STAT_NotificationBackbone_NumDispatched, STATGROUP_NotificationBackbone, NOTIFICATIONBACKBONE_API);
+
+/**
+ * What a feed did, see FNotificationBackboneFeedStats.
+ * Plain counters, only touched on the game thread. Recording costs a few additions and no allocation, so they stay on in shipping builds.
+ */
+struct NOTIFICATIONBACKBONE_API FNotificationBackboneFeedCounters
+{
+	// Bucket i counts latencies below 2^i microseconds, the last bucket the rest (about 4 seconds and above).
+	static const int32 NumLatencyBuckets = 24;
+
+	uint64 numEnqueued = 0;
+	uint64 numCoalesced = 0;
+	uint64 numDispatched = 0;
+	uint64 numDroppedNoListeners = 0;
+	uint64 numDroppedOverflow = 0;
+	uint64 numCleared = 0;
+	uint32 maxQueuedNotifications = 0;
+
+	uint64 latencyHistogram[NumLatencyBuckets] = {};
+	uint64 totalLatencyCycles = 0;
+	uint64 maxLatencyCycles = 0;
+
+	uint64 listenerCycles = 0;
+	uint64 slowestListenerCycles = 0;
+	FName slowestListener;
+
+	void RecordQueueDepth(uint32 numQueuedNotifications)
+	{
+		maxQueuedNotifications = FMath::Max(maxQueuedNotifications, numQueuedNotifications);
+	}
+
+	void RecordLatency(uint64 latencyCycles);
+
+	// Returns true when it was the slowest callback so far. The caller names the listener then, so naming stays off the common path.
+	bool RecordListenerCall(uint64 callCycles)
+	{
+		listenerCycles += callCycles;
+		if (callCycles > slowestListenerCycles)
+		{
+			slowestListenerCycles = callCycles;
+			return true;
+		}
+		return false;
+	}
+
+	// Adds the counters of other, e.g. of a feed that got destroyed.
+	void Append(const FNotificationBackboneFeedCounters& other);
+
+	// Latency in microseconds the fraction of the dispatches stayed below. Upper bound of the bucket, 0 without dispatches.
+	double GetLatencyPercentileMicroseconds(double fraction) const;
+
+	// Fills everything but the feed and the number of queued notifications.
+	void ToStats(FNotificationBackboneFeedStats& outStats) const;
+};
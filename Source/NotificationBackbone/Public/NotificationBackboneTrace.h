@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+// UE Trace (Unreal Insights) came with 4.26. Older engines get the events in the log instead.
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 26
+#include "Trace/Trace.h"
+#endif
+
+#if defined(UE_TRACE_ENABLED) && UE_TRACE_ENABLED
+#define NOTIFICATIONBACKBONE_UE_TRACE 1
+UE_TRACE_CHANNEL_EXTERN(NotificationBackboneChannel, NOTIFICATIONBACKBONE_API)
+#else
+#define NOTIFICATIONBACKBONE_UE_TRACE 0
+// "log LogNotificationBackboneTrace Verbose" to get the events.
+NOTIFICATIONBACKBONE_API DECLARE_LOG_CATEGORY_EXTERN(LogNotificationBackboneTrace, Warning, All);
+#endif
+
+// What happened to a notification. Block, Unblock and Clear are about the feed, they have no notification.
+enum class ENotificationBackboneTraceEvent : uint8
+{
+	Enqueue,
+	Coalesce,
+	Block,
+	Unblock,
+	Dequeue,
+	ListenerBegin,
+	ListenerEnd,
+	// Value is the ENotificationBackboneDispatchResult.
+	Drop,
+	// Value is the number of notifications cleared.
+	Clear
+};
+
+/**
+ * Lifecycle of the notifications in the feeds, for a timeline in Unreal Insights ("-trace=NotificationBackbone").
+ * Every notification gets an id when it comes into a feed, all of its events carry that id and the feed.
+ * Use NOTIFICATIONBACKBONE_TRACE, it only builds the event when the channel is enabled.
+ */
+struct NOTIFICATIONBACKBONE_API FNotificationBackboneTrace
+{
+	// Game thread only.
+	static uint64 NewNotificationId()
+	{
+		return ++lastNotificationId;
+	}
+
+	static bool IsEnabled()
+	{
+#if NOTIFICATIONBACKBONE_UE_TRACE
+		return UE_TRACE_CHANNELEXPR_IS_ENABLED(NotificationBackboneChannel);
+#elif NO_LOGGING
+		return false;
+#else
+		return UE_LOG_ACTIVE(LogNotificationBackboneTrace, Verbose);
+#endif
+	}
+
+	static void OutputEvent(ENotificationBackboneTraceEvent event, uint64 notificationId, const FName& feed, const FName& listener = NAME_None, uint32 value = 0);
+
+private:
+	static uint64 lastNotificationId;
+};
+
+// A statement of its own, so it can go between an if and its else.
+#define NOTIFICATIONBACKBONE_TRACE(Event, NotificationId, Feed, ...) \
+	do \
+	{ \
+		if (FNotificationBackboneTrace::IsEnabled()) \
+		{ \
+			FNotificationBackboneTrace::OutputEvent(ENotificationBackboneTraceEvent::Event, NotificationId, Feed, ##__VA_ARGS__); \
+		} \
+	} while (0)
@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "RingQueue.h"
+#include "NotificationBackboneManager.h"
+
+/**
+ * Listener of a typed channel. Gets the payload as it was dispatched, no conversion.
+ */
+template<typename PayloadType>
+class TNotificationChannelListener
+{
+public:
+	virtual ~TNotificationChannelListener() {}
+
+	virtual void OnChannelNotification(const PayloadType& payload) = 0;
+
+	// Return an appropriate name so we know who is listening. Class name is always good.
+	virtual FName GetNotificationBackboneListenerName() = 0;
+};
+
+/**
+ * Names the payload type of a channel, the same in every module. USTRUCT payloads name themselves,
+ * other payload types need NOTIFICATIONBACKBONE_CHANNEL_PAYLOAD(FMyPayload) next to their declaration.
+ */
+template<typename PayloadType>
+struct TNotificationChannelPayloadName
+{
+	static FName Get()
+	{
+		return PayloadType::StaticStruct()->GetFName();
+	}
+};
+
+#define NOTIFICATIONBACKBONE_CHANNEL_PAYLOAD(PayloadType) \
+	template<> \
+	struct TNotificationChannelPayloadName<PayloadType> \
+	{ \
+		static FName Get() \
+		{ \
+			static const FName payloadName(TEXT(#PayloadType)); \
+			return payloadName; \
+		} \
+	};
+
+/**
+ * Statically typed feed for C++ producers and consumers, e.g. TNotificationChannel<FMyDamageEvent>::Get("Damage").
+ * Channels are defined by payload type and name. The payload gets handed to the listeners as is, no text, no type erasure.
+ * The manager keeps the channels, so all modules get the same channel for the same name.
+ *
+ * Like feeds without settings:
+ *	Payloads get dispatched right away and get dropped when nobody listens.
+ *	Payloads dispatched by listeners while the channel dispatches wait inline in the channel and go out once the
+ *	current dispatch is over, so listeners are never called recursively.
+ *	Payloads dispatched from other threads wait in an inbox that gets drained with the inbox of the manager.
+ *
+ * USTRUCT payloads can be dispatched from Blueprints after calling EnableBlueprintBridge (see DispatchChannelNotification).
+ */
+template<typename PayloadType>
+class TNotificationChannel
+{
+public:
+	typedef TNotificationChannelListener<PayloadType> FListener;
+	typedef TSharedRef<TNotificationChannel, ESPMode::ThreadSafe> FChannelRef;
+
+	// Returns the channel, creates it when it does not exist yet. Game thread only.
+	// Producers on other threads must get the channel on the game thread first and hold on to it.
+	static FChannelRef Get(const FName& name)
+	{
+		check(IsInGameThread());
+
+		FNotificationBackboneManager& manager = FNotificationBackboneManager::Get();
+		const FName payloadName = TNotificationChannelPayloadName<PayloadType>::Get();
+		TSharedPtr<void, ESPMode::ThreadSafe> existing = manager.FindChannel(payloadName, name);
+		if (existing.IsValid())
+		{
+			return StaticCastSharedPtr<TNotificationChannel>(existing).ToSharedRef();
+		}
+
+		FChannelRef channel = MakeShareable(new TNotificationChannel(name));
+		FNotificationBackboneManager::FChannelEntry entry;
+		entry.channel = channel;
+		entry.flushIncomingPayloads = &TNotificationChannel::FlushIncomingPayloads;
+		entry.clearListeners = &TNotificationChannel::ClearListeners;
+		manager.AddChannel(payloadName, name, entry);
+		return channel;
+	}
+
+	// Lets Blueprints dispatch payloads of this type into the channels. PayloadType must be a USTRUCT.
+	static void EnableBlueprintBridge()
+	{
+		FNotificationBackboneManager::Get().RegisterChannelBridge(PayloadType::StaticStruct(), [](const FName& name, const void* payload)
+		{
+			return Get(name)->Dispatch(*(const PayloadType*)payload);
+		});
+	}
+
+	void RegisterListener(TSharedRef<FListener> listener)
+	{
+		check(IsInGameThread());
+
+		FListenerEntry* existing = FindListener(&listener.Get());
+		if (existing)
+		{
+			// Unsubscribed and subscribed again during the same dispatch, or a new listener at the address of a dead one.
+			existing->listener = listener;
+			existing->bRemoved = false;
+		}
+		else if (IsDispatching())
+		{
+			pendingListeners.Add(FListenerEntry{ listener, &listener.Get(), false });
+		}
+		else
+		{
+			listeners.Add(FListenerEntry{ listener, &listener.Get(), false });
+		}
+	}
+
+	void UnregisterListener(TSharedRef<FListener> listener)
+	{
+		check(IsInGameThread());
+
+		const FListener* key = &listener.Get();
+		if (IsDispatching())
+		{
+			FListenerEntry* existing = listeners.FindByPredicate([key](const FListenerEntry& entry)
+			{
+				return entry.key == key;
+			});
+			if (existing)
+			{
+				existing->bRemoved = true;
+			}
+			pendingListeners.RemoveAllSwap([key](const FListenerEntry& entry)
+			{
+				return entry.key == key;
+			});
+		}
+		else
+		{
+			listeners.RemoveAllSwap([key](const FListenerEntry& entry)
+			{
+				return entry.key == key;
+			});
+		}
+	}
+
+	/**
+	 * Can be called from any thread.
+	 * Returns false when the payload got dropped because nobody listens. Payloads from other threads always get accepted.
+	 */
+	bool Dispatch(const PayloadType& payload)
+	{
+		if (!IsInGameThread())
+		{
+			incomingPayloads.Enqueue(payload);
+			return true;
+		}
+		if (!GetDoesHaveListeners())
+		{
+			return false;
+		}
+		if (IsDispatching())
+		{
+			pendingPayloads.Enqueue(payload);
+			return true;
+		}
+
+		DispatchToListeners(payload);
+		DispatchPendingPayloads();
+		return true;
+	}
+
+	bool Dispatch(PayloadType&& payload)
+	{
+		if (!IsInGameThread())
+		{
+			incomingPayloads.Enqueue(MoveTemp(payload));
+			return true;
+		}
+		if (!GetDoesHaveListeners())
+		{
+			return false;
+		}
+		if (IsDispatching())
+		{
+			pendingPayloads.Enqueue(MoveTemp(payload));
+			return true;
+		}
+
+		DispatchToListeners(payload);
+		DispatchPendingPayloads();
+		return true;
+	}
+
+	const FName& GetChannelName() const
+	{
+		return channelName;
+	}
+
+	bool GetDoesHaveListeners() const
+	{
+		return listeners.Num() != 0 || pendingListeners.Num() != 0;
+	}
+
+	bool IsDispatching() const
+	{
+		return dispatchDepth > 0;
+	}
+
+	void GetListenerNames(TArray<FString>& outNames) const
+	{
+		outNames.Reset(listeners.Num() + pendingListeners.Num());
+		for (const FListenerEntry& entry : listeners)
+		{
+			TSharedPtr<FListener> pinned = entry.listener.Pin();
+			if (pinned.IsValid() && !entry.bRemoved)
+			{
+				outNames.Add(pinned->GetNotificationBackboneListenerName().ToString());
+			}
+		}
+		for (const FListenerEntry& entry : pendingListeners)
+		{
+			TSharedPtr<FListener> pinned = entry.listener.Pin();
+			if (pinned.IsValid())
+			{
+				outNames.Add(pinned->GetNotificationBackboneListenerName().ToString());
+			}
+		}
+	}
+
+private:
+	TNotificationChannel(const FName& name) : channelName(name) {}
+
+	struct FListenerEntry
+	{
+		TWeakPtr<FListener> listener;
+		// Identity of the listener. Used to find the entry again.
+		const FListener* key;
+		// Unsubscribed during a dispatch. Gets skipped and removed once the dispatch is over.
+		bool bRemoved;
+	};
+
+	// Called by the manager, see FNotificationBackboneManager::FChannelEntry.
+	static void FlushIncomingPayloads(void* channel)
+	{
+		static_cast<TNotificationChannel*>(channel)->FlushIncomingPayloads();
+	}
+
+	static void ClearListeners(void* channel)
+	{
+		static_cast<TNotificationChannel*>(channel)->ClearListeners();
+	}
+
+	// Returns the subscribed listener or the one waiting for the dispatch to end, nullptr if there is none.
+	FListenerEntry* FindListener(const FListener* key)
+	{
+		// Few listeners per channel, a linear search is fine.
+		auto hasKey = [key](const FListenerEntry& listener)
+		{
+			return listener.key == key;
+		};
+		FListenerEntry* entry = listeners.FindByPredicate(hasKey);
+		return entry ? entry : pendingListeners.FindByPredicate(hasKey);
+	}
+
+	void DispatchToListeners(const PayloadType& payload)
+	{
+		// The array neither grows nor shrinks while we dispatch, see RegisterListener and UnregisterListener.
+		++dispatchDepth;
+		const int32 numListeners = listeners.Num();
+		for (int32 index = 0; index < numListeners; ++index)
+		{
+			FListenerEntry& entry = listeners[index];
+			if (entry.bRemoved)
+			{
+				continue;
+			}
+
+			TSharedPtr<FListener> pinned = entry.listener.Pin();
+			if (pinned.IsValid())
+			{
+				pinned->OnChannelNotification(payload);
+			}
+			else
+			{
+				entry.bRemoved = true;
+			}
+		}
+		--dispatchDepth;
+
+		if (!IsDispatching())
+		{
+			listeners.RemoveAllSwap([](const FListenerEntry& entry)
+			{
+				return entry.bRemoved;
+			});
+			listeners.Append(pendingListeners);
+			pendingListeners.Reset();
+		}
+	}
+
+	// Sends out what listeners dispatched while we dispatched, in order. Keeps the memory for the next time.
+	void DispatchPendingPayloads()
+	{
+		PayloadType payload;
+		while (pendingPayloads.Dequeue(payload))
+		{
+			if (GetDoesHaveListeners())
+			{
+				DispatchToListeners(payload);
+			}
+		}
+	}
+
+	void FlushIncomingPayloads()
+	{
+		PayloadType payload;
+		while (incomingPayloads.Dequeue(payload))
+		{
+			if (GetDoesHaveListeners())
+			{
+				DispatchToListeners(payload);
+				DispatchPendingPayloads();
+			}
+		}
+	}
+
+	void ClearListeners()
+	{
+		listeners.Reset();
+		pendingListeners.Reset();
+		pendingPayloads.Empty();
+		while (incomingPayloads.Pop());
+	}
+
+	FName channelName;
+
+	TArray<FListenerEntry> listeners;
+	// Subscribed during a dispatch, get added once the dispatch is over.
+	TArray<FListenerEntry> pendingListeners;
+	// Nested dispatches, only the outermost one sends out the pending payloads.
+	int32 dispatchDepth = 0;
+
+	// Dispatched by listeners while we dispatch.
+	TRingQueue<PayloadType> pendingPayloads;
+	// Dispatched from other threads. Multiple producers, the game thread is the only consumer.
+	TQueue<PayloadType, EQueueMode::Mpsc> incomingPayloads;
+};
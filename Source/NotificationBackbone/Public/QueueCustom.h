@@ -3,9 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
 
 /**
  * The basic queue does not count the number of items... We do it here.
+ * The counter is atomic, so an Mpsc queue can be filled from any thread. With multiple producers
+ * the count is raised before the item is enqueued, thus it might be larger than the real number of items for a moment, never smaller.
  */
 template<typename ItemType, EQueueMode Mode = EQueueMode::Spsc>
 class NOTIFICATIONBACKBONE_API TQueueCustom : public TQueue<ItemType, Mode>
@@ -17,33 +20,35 @@ public:
 		bool retVal = TQueue::Dequeue(OutItem);
 		if (retVal)
 		{
-			--numElements;
+			numElements.Decrement();
 		}
 		return retVal;
 	}
 
+	// Consumer only, same as Dequeue.
 	void Empty()
 	{
-		TQueue::Empty();
-		numElements = 0;
+		while (Pop());
 	}
 
 	bool Enqueue(const ItemType& Item)
 	{
+		numElements.Increment();
 		bool retVal = TQueue::Enqueue(Item);
-		if (retVal)
+		if (!retVal)
 		{
-			++numElements;
+			numElements.Decrement();
 		}
 		return retVal;
 	}
 
 	bool Enqueue(ItemType&& Item)
 	{
-		bool retVal = TQueue::Enqueue(Item);
-		if (retVal)
+		numElements.Increment();
+		bool retVal = TQueue::Enqueue(MoveTemp(Item));
+		if (!retVal)
 		{
-			++numElements;
+			numElements.Decrement();
 		}
 		return retVal;
 	}
@@ -53,18 +58,19 @@ public:
 		bool retVal = TQueue::Pop();
 		if (retVal)
 		{
-			--numElements;
+			numElements.Decrement();
 		}
 		return retVal;
 	}
 
-	uint32 Num() const 
+	uint32 Num() const
 	{
-		check((IsEmpty() && numElements == 0) || (!IsEmpty() && numElements != 0));
-		return numElements;
+		// Producers on other threads make the cross check meaningless for Mpsc.
+		check(Mode == EQueueMode::Mpsc || (IsEmpty() && numElements.GetValue() == 0) || (!IsEmpty() && numElements.GetValue() != 0));
+		return (uint32)FMath::Max(numElements.GetValue(), 0);
 	}
 
 private:
 
-	uint32 numElements = 0;
+	FThreadSafeCounter numElements;
 };
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * First in first out queue on top of a ring buffer, thus no allocation per item like TQueue.
+ * Storage only gets allocated when the queue is full. Call Reserve up front to never allocate while enqueueing.
+ * Every item gets a sequence number when enqueued, so it can be found again as long as it is in the queue.
+ * Not thread safe.
+ */
+template<typename ItemType>
+class TRingQueue
+{
+public:
+	TRingQueue() {}
+
+	~TRingQueue()
+	{
+		Empty();
+		FMemory::Free(storage);
+	}
+
+	TRingQueue(const TRingQueue& other) = delete;
+	TRingQueue& operator=(const TRingQueue& other) = delete;
+
+	bool Dequeue(ItemType& OutItem)
+	{
+		if (numElements == 0)
+		{
+			return false;
+		}
+
+		ItemType& item = storage[head];
+		OutItem = MoveTemp(item);
+		DestructItem(&item);
+		Advance();
+		return true;
+	}
+
+	void Empty()
+	{
+		while (Pop());
+	}
+
+	void Enqueue(const ItemType& Item)
+	{
+		new (AllocateTail()) ItemType(Item);
+	}
+
+	void Enqueue(ItemType&& Item)
+	{
+		new (AllocateTail()) ItemType(MoveTemp(Item));
+	}
+
+	bool Pop()
+	{
+		if (numElements == 0)
+		{
+			return false;
+		}
+
+		DestructItem(storage + head);
+		Advance();
+		return true;
+	}
+
+	// Returns the oldest item, nullptr when empty.
+	ItemType* Peek()
+	{
+		return numElements != 0 ? storage + head : nullptr;
+	}
+
+	const ItemType* Peek() const
+	{
+		return numElements != 0 ? storage + head : nullptr;
+	}
+
+	// Returns the item with the sequence number, nullptr if it is not in the queue (anymore).
+	ItemType* FindBySequence(uint64 sequence)
+	{
+		if (sequence < headSequence || sequence >= GetTailSequence())
+		{
+			return nullptr;
+		}
+		return storage + ((head + (uint32)(sequence - headSequence)) & (capacity - 1));
+	}
+
+	// Sequence number of the oldest item.
+	uint64 GetHeadSequence() const
+	{
+		return headSequence;
+	}
+
+	// Sequence number the next enqueued item will get.
+	uint64 GetTailSequence() const
+	{
+		return headSequence + numElements;
+	}
+
+	bool IsEmpty() const
+	{
+		return numElements == 0;
+	}
+
+	uint32 Num() const
+	{
+		return numElements;
+	}
+
+	uint32 GetCapacity() const
+	{
+		return capacity;
+	}
+
+	// Makes room for at least minCapacity items. Never shrinks.
+	void Reserve(uint32 minCapacity)
+	{
+		if (minCapacity <= capacity)
+		{
+			return;
+		}
+
+		// Power of two, so we can wrap around with a mask.
+		const uint32 newCapacity = FMath::RoundUpToPowerOfTwo(minCapacity);
+		ItemType* newStorage = (ItemType*)FMemory::Malloc(newCapacity * sizeof(ItemType), alignof(ItemType));
+		for (uint32 i = 0; i < numElements; ++i)
+		{
+			ItemType& item = storage[(head + i) & (capacity - 1)];
+			new (newStorage + i) ItemType(MoveTemp(item));
+			DestructItem(&item);
+		}
+
+		FMemory::Free(storage);
+		storage = newStorage;
+		capacity = newCapacity;
+		head = 0;
+	}
+
+private:
+	ItemType* AllocateTail()
+	{
+		if (numElements == capacity)
+		{
+			Reserve(FMath::Max<uint32>(capacity * 2, 8));
+		}
+
+		ItemType* tail = storage + ((head + numElements) & (capacity - 1));
+		++numElements;
+		return tail;
+	}
+
+	void Advance()
+	{
+		head = (head + 1) & (capacity - 1);
+		--numElements;
+		++headSequence;
+	}
+
+	ItemType* storage = nullptr;
+	uint32 capacity = 0;
+	uint32 head = 0;
+	uint32 numElements = 0;
+	uint64 headSequence = 0;
+};